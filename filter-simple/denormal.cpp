@@ -0,0 +1,117 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/core/plugin.h>
+#include <seiscomp/math/filter.h>
+
+#include "denormal.h"
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+using namespace FilterSimple;
+
+
+/**
+ * @brief The Dither class protects the recursive filters which follow in
+ *        a filter chain from subnormal states.
+ *
+ * The filters of a chain are applied in the same thread one after
+ * another, but a filter must not change the floating point mode of that
+ * thread beyond its own apply(), hence flushing to zero cannot protect
+ * the following filters. DITHER at the head of a chain adds a dither of
+ * the given amplitude with a pseudo random sign instead. Its flat
+ * spectrum passes any following low-pass or high-pass, hence the states
+ * of filters which are not part of this plugin, e.g. the Butterworth
+ * implementations, never decay into the subnormal range:
+ *
+ * @code
+ * filter = "DITHER>>BW(3,1,10)>>STALTA(2,80)"
+ * @endcode
+ *
+ * The default amplitude of 1E-20 is far below the resolution of any
+ * digitizer and far above the subnormal range of float and double.
+ */
+template <typename T>
+class Dither : public Math::Filtering::InPlaceFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		Dither(double dither = 1E-20)
+		: _dither(static_cast<T>(dither)) {}
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void setSamplingFrequency(double fsamp) override {}
+
+		int setParameters(int n, const double *params) override {
+			if ( n > 1 ) {
+				return 1;
+			}
+
+			if ( n > 0 ) {
+				if ( params[0] < 0 ) {
+					return -1;
+				}
+
+				_dither = static_cast<T>(params[0]);
+			}
+
+			return n;
+		}
+
+		void apply(int n, T *inout) override {
+			// Subnormal input samples are flushed while the dither is added,
+			// the previous mode is restored when returning
+			DenormalGuard guard;
+
+			for ( int i = 0; i < n; ++i ) {
+				// The sign is the top bit of a linear congruential generator,
+				// the arithmetic shift yields -1 or 0 without a branch
+				_state = _state * 1664525u + 1013904223u;
+				inout[i] += _dither * static_cast<T>((static_cast<int32_t>(_state) >> 31) | 1);
+			}
+		}
+
+		Math::Filtering::InPlaceFilter<T>* clone() const override {
+			return new Dither<T>(_dither);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		T        _dither;
+		uint32_t _state{1};
+};
+
+
+INSTANTIATE_INPLACE_FILTER(Dither, SC_SYSTEM_CORE_API);
+REGISTER_INPLACE_FILTER(Dither, "DITHER");
+
+
+}
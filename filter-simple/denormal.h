@@ -0,0 +1,91 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_FILTERSIMPLE_DENORMAL_H
+#define SEISCOMP_TEMPLATES_FILTERSIMPLE_DENORMAL_H
+
+
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+
+namespace FilterSimple {
+
+
+/**
+ * Subnormal operands take a micro-code path on most x86 CPUs which is
+ * up to two orders of magnitude slower. Recursive filter states decay
+ * into that range during long periods of silence. The floating point
+ * control register of the calling thread can flush those values to zero
+ * (FTZ) and treat subnormal inputs as zero (DAZ).
+ */
+#if defined(__SSE__)
+#define FILTERSIMPLE_HAS_FTZ
+using FPState = unsigned int;
+// FTZ is bit 15, DAZ is bit 6 of MXCSR
+constexpr FPState FlushBits = 0x8040;
+inline FPState fpState() { return _mm_getcsr(); }
+inline void setFPState(FPState state) { _mm_setcsr(state); }
+#elif defined(__aarch64__)
+#define FILTERSIMPLE_HAS_FTZ
+using FPState = uint64_t;
+// FZ is bit 24 of FPCR and covers both, outputs and inputs
+constexpr FPState FlushBits = FPState(1) << 24;
+inline FPState fpState() { FPState r; asm volatile("mrs %0, fpcr" : "=r"(r)); return r; }
+inline void setFPState(FPState state) { asm volatile("msr fpcr, %0" : : "r"(state)); }
+#endif
+
+
+/**
+ * @brief Enables FTZ/DAZ for the lifetime of the guard in the calling
+ *        thread and restores the previous mode afterwards.
+ *
+ * The control register is only written if the mode actually changes
+ * which keeps the guard cheap enough to be placed around each apply().
+ */
+class DenormalGuard {
+	public:
+#if defined(FILTERSIMPLE_HAS_FTZ)
+		DenormalGuard() : _saved(fpState()) {
+			if ( (_saved & FlushBits) != FlushBits ) {
+				setFPState(_saved | FlushBits);
+			}
+		}
+
+		~DenormalGuard() {
+			if ( (_saved & FlushBits) != FlushBits ) {
+				setFPState(_saved);
+			}
+		}
+
+	private:
+		FPState _saved;
+#else
+		DenormalGuard() {}
+#endif
+
+	public:
+		DenormalGuard(const DenormalGuard &) = delete;
+		DenormalGuard &operator=(const DenormalGuard &) = delete;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,283 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/core/plugin.h>
+#include <seiscomp/math/filter.h>
+
+#include "snapshot.h"
+#include "statistics.h"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+using namespace FilterSimple;
+
+
+/**
+ * @brief The MedianFilter class computes a running median over a sliding
+ *        window and optionally uses it to remove spikes.
+ *
+ * @code
+ * filter = "MEDIAN(1)"       # running median of one second
+ * filter = "MEDIAN(1,5000)"  # replace samples deviating more than 5000
+ *                            # counts from the running median
+ * @endcode
+ *
+ * The window always has an odd number of samples and ends with the
+ * newest sample. The running median therefore lags the signal by half the
+ * window length. In despike mode the newest sample is tested against the
+ * median of the window and passed or replaced without delay, hence the
+ * filter can precede a picker.
+ *
+ * The samples of the window are kept in an ordered multiset with an
+ * iterator to the median. Each new sample replaces the oldest one in
+ * O(log w) and the median iterator moves by at most one position.
+ * The tree node of the outgoing sample is reused for the incoming sample
+ * which keeps the hot loop free of allocations.
+ *
+ * The window is part of the filter snapshot, see StatefulFilter.
+ */
+template <typename T>
+class MedianFilter : public StatefulFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		MedianFilter(double length = 1.0, double threshold = 0.0)
+		: _length(length), _threshold(threshold) {}
+
+		//! D'tor
+		~MedianFilter() override {
+			this->storeSnapshot(_fsamp);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void setSamplingFrequency(double fsamp) override {
+			_fsamp = fsamp;
+			this->setStateSamplingFrequency(fsamp);
+			_windowSize = 2 * static_cast<int>(_length * fsamp * 0.5) + 1;
+			if ( _windowSize < 3 ) {
+				_windowSize = 3;
+			}
+
+			_samples.clear();
+			_window.clear();
+		}
+
+		int setParameters(int n, const double *params) override {
+			if ( n < 1 ) {
+				return 1;
+			}
+
+			if ( n > 2 ) {
+				return 2;
+			}
+
+			if ( params[0] <= 0 ) {
+				return -1;
+			}
+
+			_length = params[0];
+
+			if ( n > 1 ) {
+				if ( params[1] < 0 ) {
+					return -2;
+				}
+
+				_threshold = params[1];
+			}
+
+			return n;
+		}
+
+		void apply(int n, T *inout) override {
+			if ( n <= 0 ) {
+				return;
+			}
+
+			ThroughputScope scope(_counter, "MEDIAN", { _length, _threshold }, n);
+
+			if ( _samples.empty() && !this->restoreSnapshot(_fsamp) ) {
+				init(inout[0]);
+			}
+
+			const T threshold = static_cast<T>(_threshold);
+
+			for ( int i = 0; i < n; ++i ) {
+				T x = inout[i];
+				T y = _samples[_head];
+				_samples[_head] = x;
+
+				if ( ++_head == _windowSize ) {
+					_head = 0;
+				}
+
+				replace(y, x);
+
+				if ( threshold > 0 ) {
+					// The window keeps the original sample, a single spike
+					// moves the median by one rank at most.
+					inout[i] = abs(x - *_median) > threshold ? *_median : x;
+				}
+				else {
+					inout[i] = *_median;
+				}
+			}
+
+			this->advance(n);
+		}
+
+		Math::Filtering::InPlaceFilter<T>* clone() const override {
+			return new MedianFilter<T>(_length, _threshold);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Public StatefulFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void reset() override {
+			// The next sample fills the window
+			_samples.clear();
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Protected StatefulFilter interface
+	// ------------------------------------------------------------------
+	protected:
+		string signature() const override {
+			return makeSignature("MEDIAN", { _length, _threshold });
+		}
+
+		void saveState(StateWriter &writer) const override {
+			writer.write(_windowSize);
+			writer.write(_head);
+			writer.write(_samples.data(), _samples.size());
+		}
+
+		bool restoreState(StateReader &reader) override {
+			int windowSize, head;
+			if ( !reader.read(windowSize) || windowSize != _windowSize
+			  || !reader.read(head) || head < 0 || head >= windowSize ) {
+				return false;
+			}
+
+			vector<T> samples(windowSize);
+			if ( !reader.read(samples.data(), samples.size()) ) {
+				return false;
+			}
+
+			_samples = std::move(samples);
+			_head = head;
+			_window = Window(_samples.begin(), _samples.end());
+			_median = next(_window.begin(), _windowSize / 2);
+			return true;
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private methods
+	// ------------------------------------------------------------------
+	private:
+		void init(T value) {
+			// Start with a window of constant values which is the steady
+			// state of a constant input and avoids partial windows.
+			_samples.assign(_windowSize, value);
+			_window.clear();
+			for ( int i = 0; i < _windowSize; ++i ) {
+				_window.insert(value);
+			}
+
+			_median = next(_window.begin(), _windowSize / 2);
+			_head = 0;
+		}
+
+		/**
+		 * Replaces the oldest value with the newest value and keeps the
+		 * median iterator at index w/2.
+		 */
+		void replace(T oldest, T newest) {
+			int half = _windowSize / 2;
+			int index = half;
+
+			auto it = _window.lower_bound(oldest);
+			if ( it == _median ) {
+				// The successor moves into the median position
+				++_median;
+			}
+			else if ( !(*_median < oldest) ) {
+				// Removed before the median
+				--index;
+			}
+
+			auto node = _window.extract(it);
+			node.value() = newest;
+
+			// Equal values are inserted after existing ones and therefore
+			// after the median.
+			if ( newest < *_median ) {
+				++index;
+			}
+
+			_window.insert(std::move(node));
+
+			if ( index < half ) {
+				++_median;
+			}
+			else if ( index > half ) {
+				--_median;
+			}
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		using Window = multiset<T>;
+
+		double                    _length;
+		double                    _threshold;
+		double                    _fsamp{0};
+		int                       _windowSize{3};
+		int                       _head{0};
+		vector<T>                 _samples;
+		Window                    _window;
+		typename Window::iterator _median;
+		ThroughputCounter         _counter;
+};
+
+
+INSTANTIATE_INPLACE_FILTER(MedianFilter, SC_SYSTEM_CORE_API);
+REGISTER_INPLACE_FILTER(MedianFilter, "MEDIAN");
+
+
+}
@@ -0,0 +1,219 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/core/typedarray.h>
+
+#include "pipeline.h"
+
+#include <cmath>
+#include <stdexcept>
+
+
+namespace FilterSimple {
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+template <typename T>
+struct ArrayType;
+
+template <>
+struct ArrayType<float> {
+	static constexpr Array::DataType Value = Array::FLOAT;
+};
+
+template <>
+struct ArrayType<double> {
+	static constexpr Array::DataType Value = Array::DOUBLE;
+};
+
+
+}
+
+
+template <typename T>
+FilterPipeline<T>::FilterPipeline(const string &filter, size_t workers,
+                                  size_t maxPending, Callback callback)
+: _callback(std::move(callback)), _maxPending(max(maxPending, size_t(1))) {
+	string error;
+	_prototype.reset(Math::Filtering::InPlaceFilter<T>::Create(filter, &error));
+	if ( !_prototype ) {
+		throw runtime_error("invalid filter " + filter + ": " + error);
+	}
+
+	workers = max(workers, size_t(1));
+	for ( size_t i = 0; i < workers; ++i ) {
+		_workers.emplace_back(&FilterPipeline<T>::run, this);
+	}
+}
+
+
+template <typename T>
+FilterPipeline<T>::~FilterPipeline() {
+	{
+		unique_lock<mutex> lock(_mutex);
+		_stopping = true;
+	}
+
+	_workAvailable.notify_all();
+
+	for ( auto &worker : _workers ) {
+		worker.join();
+	}
+}
+
+
+template <typename T>
+bool FilterPipeline<T>::feed(const Record *rec) {
+	if ( !rec ) {
+		return false;
+	}
+
+	unique_lock<mutex> lock(_mutex);
+	_spaceAvailable.wait(lock, [this] { return _pending < _maxPending; });
+
+	auto &stream = _streams[rec->streamID()];
+	if ( !stream ) {
+		stream.reset(new Stream);
+	}
+
+	stream->queue.emplace_back(rec);
+	++_pending;
+
+	// A stream is in the ready queue at most once which serializes its
+	// records.
+	if ( !stream->scheduled ) {
+		stream->scheduled = true;
+		_ready.push_back(stream.get());
+		lock.unlock();
+		_workAvailable.notify_one();
+	}
+
+	return true;
+}
+
+
+template <typename T>
+void FilterPipeline<T>::flush() {
+	unique_lock<mutex> lock(_mutex);
+	_drained.wait(lock, [this] { return _pending == 0; });
+}
+
+
+template <typename T>
+void FilterPipeline<T>::run() {
+	unique_lock<mutex> lock(_mutex);
+
+	while ( true ) {
+		_workAvailable.wait(lock, [this] { return _stopping || !_ready.empty(); });
+		if ( _ready.empty() ) {
+			// Stopping and all records are processed
+			break;
+		}
+
+		// Take one record of the stream and requeue the stream afterwards
+		// such that busy streams cannot starve others.
+		Stream *stream = _ready.front();
+		_ready.pop_front();
+		RecordCPtr rec = stream->queue.front();
+		stream->queue.pop_front();
+
+		lock.unlock();
+		process(*stream, rec.get());
+		rec = nullptr;
+		lock.lock();
+
+		if ( stream->queue.empty() ) {
+			stream->scheduled = false;
+		}
+		else {
+			_ready.push_back(stream);
+			_workAvailable.notify_one();
+		}
+
+		if ( _pending-- == _maxPending ) {
+			_spaceAvailable.notify_all();
+		}
+
+		if ( !_pending ) {
+			_drained.notify_all();
+		}
+	}
+}
+
+
+template <typename T>
+void FilterPipeline<T>::process(Stream &stream, const Record *rec) {
+	const Array *data = rec->data();
+	if ( !data ) {
+		SEISCOMP_WARNING("%s: record without data", rec->streamID());
+		return;
+	}
+
+	auto *samples = static_cast<TypedArray<T>*>(data->copy(ArrayType<T>::Value));
+	GenericRecordPtr out = new GenericRecord(rec->networkCode(), rec->stationCode(),
+	                                         rec->locationCode(), rec->channelCode(),
+	                                         rec->startTime(), rec->samplingFrequency());
+	out->setData(samples);
+
+	double fsamp = rec->samplingFrequency();
+
+	bool continuous = stream.filter && stream.fsamp == fsamp
+	               && fabs(static_cast<double>(rec->startTime() - stream.nextTime)) <= 0.5 / fsamp;
+
+	if ( !continuous ) {
+		if ( stream.stateful ) {
+			// Gaps and overlaps keep the tables and buffers of the filter
+			stream.stateful->reset();
+		}
+		else {
+			// The first record of a stream. InPlaceFilter has no reset,
+			// hence filter chains and the filters of other plugins are
+			// replaced by a new instance on gaps and overlaps.
+			stream.filter.reset(_prototype->clone());
+			stream.filter->setStreamID(rec->networkCode(), rec->stationCode(),
+			                           rec->locationCode(), rec->channelCode());
+			stream.stateful = dynamic_cast<StatefulFilter<T>*>(stream.filter.get());
+			stream.fsamp = 0;
+		}
+
+		stream.filter->setStartTime(rec->startTime());
+
+		if ( stream.fsamp != fsamp ) {
+			stream.filter->setSamplingFrequency(fsamp);
+			stream.fsamp = fsamp;
+		}
+	}
+
+	stream.filter->apply(samples->size(), samples->typedData());
+	stream.nextTime = rec->endTime();
+
+	_callback(out.get());
+}
+
+
+template class FilterPipeline<float>;
+template class FilterPipeline<double>;
+
+
+}
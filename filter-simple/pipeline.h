@@ -0,0 +1,142 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_FILTERSIMPLE_PIPELINE_H
+#define SEISCOMP_TEMPLATES_FILTERSIMPLE_PIPELINE_H
+
+
+#include <seiscomp/core/genericrecord.h>
+#include <seiscomp/core/record.h>
+#include <seiscomp/math/filter.h>
+
+#include "snapshot.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace FilterSimple {
+
+
+/**
+ * @brief Runs a filter chain on records in a bounded pool of worker
+ *        threads.
+ *
+ * The acquisition thread only enqueues records with feed(). Each stream
+ * has its own filter instance and queue. A stream is processed by at
+ * most one worker at a time, hence the records of a stream are filtered
+ * and delivered in the order they were fed, while different streams
+ * are filtered in parallel. If the configured number of records is
+ * pending, feed() blocks until the workers caught up (back-pressure).
+ *
+ * @code
+ * FilterPipeline<double> pipeline("BW(3,1,10)>>STALTA(2,80)", 4, 1000,
+ *                                 [](GenericRecord *rec) { ... });
+ * pipeline.feed(rec);
+ * @endcode
+ */
+template <typename T>
+class FilterPipeline {
+	// ------------------------------------------------------------------
+	//  Public types
+	// ------------------------------------------------------------------
+	public:
+		//! Receives the filtered records. It is called from the worker
+		//! threads, calls for different streams can run concurrently.
+		using Callback = std::function<void (Seiscomp::GenericRecord *)>;
+
+
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief C'tor
+		 * @param filter The filter string, e.g. "BW(3,1,10)"
+		 * @param workers The number of worker threads
+		 * @param maxPending The maximum number of queued records
+		 * @param callback The receiver of the filtered records
+		 * @throws std::runtime_error if the filter string is invalid
+		 */
+		FilterPipeline(const std::string &filter, size_t workers,
+		               size_t maxPending, Callback callback);
+
+		//! D'tor, processes all pending records and joins the workers
+		~FilterPipeline();
+
+		FilterPipeline(const FilterPipeline &) = delete;
+		FilterPipeline &operator=(const FilterPipeline &) = delete;
+
+
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief Enqueues a record. Blocks while maxPending records are
+		 *        queued.
+		 * @return false if rec is nullptr
+		 */
+		bool feed(const Seiscomp::Record *rec);
+
+		//! Waits until all fed records have been delivered
+		void flush();
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		using FilterPtr = std::unique_ptr<Seiscomp::Math::Filtering::InPlaceFilter<T>>;
+
+		struct Stream {
+			FilterPtr                                filter;
+			//! The filter if it can be reset cheaply, otherwise nullptr
+			StatefulFilter<T>                       *stateful{nullptr};
+			Seiscomp::Core::Time                     nextTime;
+			double                                   fsamp{0};
+			bool                                     scheduled{false};
+			std::deque<Seiscomp::RecordCPtr>         queue;
+		};
+
+		void run();
+		void process(Stream &stream, const Seiscomp::Record *rec);
+
+		FilterPtr                                          _prototype;
+		Callback                                           _callback;
+		size_t                                             _maxPending;
+		size_t                                             _pending{0};
+		bool                                               _stopping{false};
+		std::mutex                                         _mutex;
+		std::condition_variable                            _workAvailable;
+		std::condition_variable                            _spaceAvailable;
+		std::condition_variable                            _drained;
+		std::unordered_map<std::string, std::unique_ptr<Stream>> _streams;
+		std::deque<Stream*>                                _ready;
+		std::vector<std::thread>                           _workers;
+};
+
+
+}
+
+
+#endif
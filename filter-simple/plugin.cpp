@@ -19,12 +19,15 @@
 #include <seiscomp/core/plugin.h>
 #include <seiscomp/math/filter.h>
 
+#include "statistics.h"
+
 
 namespace {
 
 
 using namespace std;
 using namespace Seiscomp;
+using namespace FilterSimple;
 
 
 /**
@@ -48,7 +51,9 @@ class SimpleFilter : public Math::Filtering::InPlaceFilter<T> {
 	public:
 		//! C'tor
 		SimpleFilter(double scale = 1.0, double offset = 0.0)
-		: _scale(scale), _offset(offset) {}
+		: _scale(scale), _offset(offset) {
+			selectKernel();
+		}
 
 
 	// ------------------------------------------------------------------
@@ -73,14 +78,40 @@ class SimpleFilter : public Math::Filtering::InPlaceFilter<T> {
 			// Set the internal parameters according to the input parameters.
 			_scale = params[0];
 			_offset = params[1];
+			selectKernel();
 
 			return 2;
 		}
 
 		void apply(int n, T *inout) override {
-			// Simply apply the parameters to the input data.
-			for ( int i = 0; i < n; ++i, ++inout ) {
-				*inout = *inout * _scale + _offset;
+			// Simply apply the parameters to the input data. The kernel
+			// was chosen with the parameters, the identity does not touch
+			// the data at all.
+			ThroughputScope scope(_counter, "SIMPLE", { _scale, _offset }, n);
+
+			// The coefficients have the sample type, float data is never
+			// promoted to double and uses the full vector width.
+			const T a = _a;
+			const T b = _b;
+
+			switch ( _kernel ) {
+				case Identity:
+					break;
+				case Scale:
+					for ( int i = 0; i < n; ++i ) {
+						inout[i] *= a;
+					}
+					break;
+				case Offset:
+					for ( int i = 0; i < n; ++i ) {
+						inout[i] += b;
+					}
+					break;
+				case Affine:
+					for ( int i = 0; i < n; ++i ) {
+						inout[i] = inout[i] * a + b;
+					}
+					break;
 			}
 		}
 
@@ -89,12 +120,42 @@ class SimpleFilter : public Math::Filtering::InPlaceFilter<T> {
 		}
 
 
+	// ------------------------------------------------------------------
+	//  Private methods
+	// ------------------------------------------------------------------
+	private:
+		void selectKernel() {
+			// Select on the rounded coefficients, a scale which is one in
+			// single precision is the identity for float data.
+			_a = static_cast<T>(_scale);
+			_b = static_cast<T>(_offset);
+
+			if ( _a == T(1) ) {
+				_kernel = _b == T(0) ? Identity : Offset;
+			}
+			else {
+				_kernel = _b == T(0) ? Scale : Affine;
+			}
+		}
+
+
 	// ------------------------------------------------------------------
 	//  Private members
 	// ------------------------------------------------------------------
 	private:
-		double _scale{1.0};
-		double _offset{0.0};
+		enum Kernel {
+			Identity,
+			Scale,
+			Offset,
+			Affine
+		};
+
+		double            _scale{1.0};
+		double            _offset{0.0};
+		T                 _a{1};
+		T                 _b{0};
+		Kernel            _kernel{Identity};
+		ThroughputCounter _counter;
 };
 
 
@@ -106,7 +167,7 @@ REGISTER_INPLACE_FILTER(SimpleFilter, "SIMPLE");
 
 
 ADD_SC_PLUGIN(
-	"Filter plugin template, it implements a simple scale and offset filter",
+	"Filter plugin template, it implements scale and offset, transform, median and resampling filters",
 	"Jan Becker, gempa GmbH",
 	0, 0, 1
 )
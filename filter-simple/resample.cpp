@@ -0,0 +1,491 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/core/plugin.h>
+
+#include "denormal.h"
+#include "resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace FilterSimple {
+
+
+namespace {
+
+
+using namespace std;
+
+
+// Larger factors would create tables of several MB per ratio.
+constexpr int MaxFactor = 1000;
+// Kaiser window shape, the same default as scipy.signal.resample_poly.
+constexpr double KaiserBeta = 5.0;
+
+
+double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	double q = x * x * 0.25;
+	for ( int k = 1; k < 64; ++k ) {
+		term *= q / (double(k) * double(k));
+		sum += term;
+		if ( term < sum * 1E-17 ) {
+			break;
+		}
+	}
+	return sum;
+}
+
+
+/**
+ * @brief Designs a Kaiser windowed-sinc low-pass.
+ * @param halfLength The number of taps on each side of the center tap
+ * @param cutoff The corner in cycles per sample of the design rate
+ * @param gain The DC gain
+ */
+vector<double> designLowPass(int halfLength, double cutoff, double gain) {
+	int n = 2 * halfLength + 1;
+	vector<double> h(n);
+	double norm = 1.0 / besselI0(KaiserBeta);
+
+	for ( int i = 0; i < n; ++i ) {
+		double t = i - halfLength;
+		double x = 2.0 * cutoff * t;
+		double sinc = t == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+		double r = t / halfLength;
+		double w = besselI0(KaiserBeta * sqrt(max(0.0, 1.0 - r * r))) * norm;
+		h[i] = 2.0 * cutoff * sinc * w * gain;
+	}
+
+	return h;
+}
+
+
+// Phases are padded to a multiple of the vector width to avoid a
+// scalar tail in the inner product.
+int paddedTaps(int taps) {
+	return (taps + 3) & ~3;
+}
+
+
+template <typename T>
+inline T dot(const T *a, const T *b, int n) {
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for ( int i = 0; i < n; i += 4 ) {
+		s0 += a[i] * b[i];
+		s1 += a[i+1] * b[i+1];
+		s2 += a[i+2] * b[i+2];
+		s3 += a[i+3] * b[i+3];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+
+#if defined(__SSE2__)
+template <>
+inline float dot<float>(const float *a, const float *b, int n) {
+	__m128 acc0 = _mm_setzero_ps();
+	__m128 acc1 = _mm_setzero_ps();
+	int i = 0;
+	for ( ; i + 8 <= n; i += 8 ) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	for ( ; i < n; i += 4 ) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+
+template <>
+inline double dot<double>(const double *a, const double *b, int n) {
+	__m128d acc0 = _mm_setzero_pd();
+	__m128d acc1 = _mm_setzero_pd();
+	for ( int i = 0; i < n; i += 4 ) {
+		acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+	return lanes[0] + lanes[1];
+}
+#endif
+
+
+template <typename T>
+shared_ptr<const PhaseTable<T>> createTable(int up, int down,
+                                            int zeroCrossings,
+                                            bool singlePhase) {
+	auto table = make_shared<PhaseTable<T>>();
+	vector<double> h;
+
+	if ( singlePhase ) {
+		// Runs at the input rate with the corner of the target Nyquist
+		// frequency.
+		int halfLength = static_cast<int>(ceil(double(zeroCrossings) * down / up));
+		h = designLowPass(halfLength, 0.5 * up / down, 1.0);
+		table->phases = 1;
+	}
+	else {
+		// Runs at the upsampled rate. The gain compensates the energy
+		// loss of the zero insertion.
+		int maxFactor = max(up, down);
+		h = designLowPass(zeroCrossings * maxFactor, 0.5 / maxFactor, up);
+		table->phases = up;
+	}
+
+	int taps = (static_cast<int>(h.size()) + table->phases - 1) / table->phases;
+	table->taps = paddedTaps(taps);
+	table->coefficients.assign(table->phases * table->taps, T(0));
+
+	// Phase p holds h[p + k*L] for k = 0..taps-1 in reversed order. The
+	// reversed and zero padded layout pairs the last coefficient with the
+	// newest sample.
+	for ( int p = 0; p < table->phases; ++p ) {
+		T *coeffs = table->coefficients.data() + p * table->taps;
+		for ( int k = 0; k < taps; ++k ) {
+			size_t idx = p + size_t(k) * table->phases;
+			if ( idx < h.size() ) {
+				coeffs[table->taps - 1 - k] = static_cast<T>(h[idx]);
+			}
+		}
+	}
+
+	return table;
+}
+
+
+}
+
+
+template <typename T>
+shared_ptr<const PhaseTable<T>> PhaseTable<T>::Get(int up, int down,
+                                                   int zeroCrossings,
+                                                   bool singlePhase) {
+	using Key = tuple<int, int, int, bool>;
+	static mutex tableMutex;
+	static map<Key, shared_ptr<const PhaseTable<T>>> tables;
+
+	lock_guard<mutex> lock(tableMutex);
+	auto &table = tables[Key(up, down, zeroCrossings, singlePhase)];
+	if ( !table ) {
+		table = createTable<T>(up, down, zeroCrossings, singlePhase);
+		SEISCOMP_DEBUG("Created %s phase table for %d/%d with %d x %d taps",
+		               singlePhase ? "single" : "polyphase",
+		               up, down, table->phases, table->taps);
+	}
+
+	return table;
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::Delay::reset(int n) {
+	length = n;
+	head = 0;
+	buffer.assign(2 * size_t(n), T(0));
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::Delay::fill(T value) {
+	std::fill(buffer.begin(), buffer.end(), value);
+}
+
+
+template <typename T>
+const T *PolyphaseResampler<T>::Delay::push(T x) {
+	// The buffer holds every sample twice such that the last length
+	// samples are always contiguous.
+	if ( ++head == length ) {
+		head = 0;
+	}
+	buffer[head] = buffer[head + length] = x;
+	return buffer.data() + head + 1;
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::Delay::save(StateWriter &writer) const {
+	writer.write(length);
+	writer.write(head);
+	writer.write(buffer.data(), buffer.size());
+}
+
+
+template <typename T>
+bool PolyphaseResampler<T>::Delay::restore(StateReader &reader) {
+	int n, h;
+	if ( !reader.read(n) || n != length
+	  || !reader.read(h) || h < 0 || (n > 0 && h >= n) ) {
+		return false;
+	}
+
+	head = h;
+	return reader.read(buffer.data(), buffer.size());
+}
+
+
+template <typename T>
+PolyphaseResampler<T>::PolyphaseResampler(double targetFrequency, int zeroCrossings)
+: _targetFrequency(targetFrequency), _zeroCrossings(zeroCrossings) {}
+
+
+template <typename T>
+PolyphaseResampler<T>::~PolyphaseResampler() {
+	this->storeSnapshot(_fsamp);
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::setSamplingFrequency(double fsamp) {
+	_fsamp = fsamp;
+	this->setStateSamplingFrequency(fsamp);
+	_table.reset();
+	_antiAlias.reset();
+	_history.reset(0);
+	_inplaceHistory.reset(0);
+	_up = _down = 1;
+	_phase = 0;
+
+	if ( fsamp <= 0 || _targetFrequency <= 0 ) {
+		return;
+	}
+
+	// Derive the rational ratio with a resolution of 1 mHz which covers
+	// sub-Hertz channels as well.
+	long long in = llround(fsamp * 1000);
+	long long out = llround(_targetFrequency * 1000);
+
+	if ( in <= 0 || out <= 0 ) {
+		SEISCOMP_WARNING("RESAMPLE: %f Hz or %f Hz is below the resolution of 1 mHz, "
+		                 "passing data through",
+		                 fsamp, _targetFrequency);
+		return;
+	}
+
+	long long g = gcd(in, out);
+	in /= g;
+	out /= g;
+
+	if ( in > MaxFactor || out > MaxFactor ) {
+		SEISCOMP_WARNING("RESAMPLE: ratio %lld/%lld from %f Hz to %f Hz is too large, "
+		                 "passing data through",
+		                 out, in, fsamp, _targetFrequency);
+		return;
+	}
+
+	_up = static_cast<int>(out);
+	_down = static_cast<int>(in);
+
+	if ( _up == _down ) {
+		return;
+	}
+
+	_table = PhaseTable<T>::Get(_up, _down, _zeroCrossings, false);
+	_history.reset(_table->taps);
+	_restorePending = true;
+	_primePending = true;
+
+	// Upsampling cannot alias, the in-place path is a pass-through then.
+	if ( _up < _down ) {
+		_antiAlias = PhaseTable<T>::Get(_up, _down, _zeroCrossings, true);
+		_inplaceHistory.reset(_antiAlias->taps);
+	}
+}
+
+
+template <typename T>
+int PolyphaseResampler<T>::setParameters(int n, const double *params) {
+	if ( n < 1 ) {
+		return 1;
+	}
+
+	if ( n > 2 ) {
+		return 2;
+	}
+
+	// Also rejects NaN
+	if ( !(params[0] > 0) ) {
+		return -1;
+	}
+
+	_targetFrequency = params[0];
+
+	if ( n > 1 ) {
+		if ( params[1] < 1 ) {
+			return -2;
+		}
+
+		_zeroCrossings = static_cast<int>(params[1]);
+	}
+
+	return n;
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::apply(int n, T *inout) {
+	if ( !_antiAlias || n <= 0 ) {
+		return;
+	}
+
+	prepare(inout[0]);
+
+	ThroughputScope scope(_counter, "RESAMPLE", { _targetFrequency, double(_zeroCrossings) }, n);
+	DenormalGuard guard;
+	const T *coeffs = _antiAlias->phase(0);
+	int taps = _antiAlias->taps;
+
+	for ( int i = 0; i < n; ++i ) {
+		inout[i] = dot(coeffs, _inplaceHistory.push(inout[i]), taps);
+	}
+
+	this->advance(n);
+}
+
+
+template <typename T>
+Seiscomp::Math::Filtering::InPlaceFilter<T>* PolyphaseResampler<T>::clone() const {
+	return new PolyphaseResampler<T>(_targetFrequency, _zeroCrossings);
+}
+
+
+template <typename T>
+size_t PolyphaseResampler<T>::resample(int n, const T *in, vector<T> &out) {
+	if ( !_table ) {
+		out.insert(out.end(), in, in + n);
+		return n;
+	}
+
+	if ( n <= 0 ) {
+		return 0;
+	}
+
+	prepare(in[0]);
+
+	ThroughputScope scope(_counter, "RESAMPLE", { _targetFrequency, double(_zeroCrossings) }, n);
+	DenormalGuard guard;
+	size_t start = out.size();
+	int taps = _table->taps;
+
+	// Expected output count, avoids reallocations for large blocks.
+	out.reserve(start + size_t(n) * _up / _down + 1);
+
+	for ( int i = 0; i < n; ++i ) {
+		const T *window = _history.push(in[i]);
+		// Emit every output sample whose upsampled index falls into the
+		// interval of the current input sample.
+		for ( ; _phase < _up; _phase += _down ) {
+			out.push_back(dot(_table->phase(_phase), window, taps));
+		}
+		_phase -= _up;
+	}
+
+	this->advance(n);
+	return out.size() - start;
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::reset() {
+	_phase = 0;
+	_primePending = true;
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::prepare(T first) {
+	if ( _restorePending ) {
+		_restorePending = false;
+		if ( this->restoreSnapshot(_fsamp) ) {
+			_primePending = false;
+			return;
+		}
+	}
+
+	if ( _primePending ) {
+		// The steady state of a constant input is a delay line filled
+		// with that constant.
+		_primePending = false;
+		_history.fill(first);
+		_inplaceHistory.fill(first);
+	}
+}
+
+
+template <typename T>
+string PolyphaseResampler<T>::signature() const {
+	return makeSignature("RESAMPLE", { _targetFrequency, double(_zeroCrossings) });
+}
+
+
+template <typename T>
+void PolyphaseResampler<T>::saveState(StateWriter &writer) const {
+	writer.write(_phase);
+	_history.save(writer);
+	_inplaceHistory.save(writer);
+}
+
+
+template <typename T>
+bool PolyphaseResampler<T>::restoreState(StateReader &reader) {
+	// Restore into copies to not leave a partially restored state behind
+	int phase;
+	Delay history = _history, inplaceHistory = _inplaceHistory;
+	if ( !reader.read(phase) || phase < 0 || phase >= _up
+	  || !history.restore(reader) || !inplaceHistory.restore(reader) ) {
+		return false;
+	}
+
+	_phase = phase;
+	_history = std::move(history);
+	_inplaceHistory = std::move(inplaceHistory);
+	return true;
+}
+
+
+INSTANTIATE_INPLACE_FILTER(PolyphaseResampler, SC_SYSTEM_CORE_API);
+
+
+}
+
+
+namespace {
+
+
+using namespace FilterSimple;
+
+
+REGISTER_INPLACE_FILTER(PolyphaseResampler, "RESAMPLE");
+
+
+}
@@ -0,0 +1,179 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_FILTERSIMPLE_RESAMPLE_H
+#define SEISCOMP_TEMPLATES_FILTERSIMPLE_RESAMPLE_H
+
+
+#include <seiscomp/math/filter.h>
+
+#include "snapshot.h"
+#include "statistics.h"
+
+#include <memory>
+#include <vector>
+
+
+namespace FilterSimple {
+
+
+/**
+ * @brief Polyphase decomposition of a windowed-sinc low-pass.
+ *
+ * The table is designed once per rational ratio up/down and shared by all
+ * filter instances which use the same ratio, see Get(). Each phase is
+ * stored contiguously and reversed such that an output sample is a plain
+ * inner product with the last `taps` input samples (oldest first).
+ */
+template <typename T>
+struct PhaseTable {
+	int            phases{1};
+	int            taps{0};
+	std::vector<T> coefficients;
+
+	const T *phase(int p) const { return coefficients.data() + p * taps; }
+
+	/**
+	 * @brief Returns the cached table for a given ratio.
+	 * @param up The interpolation factor L
+	 * @param down The decimation factor M
+	 * @param zeroCrossings The number of sinc zero crossings per side
+	 * @param singlePhase If true then a single phase low-pass with the
+	 *                    anti-alias corner of the ratio is returned which
+	 *                    runs at the input rate.
+	 */
+	static std::shared_ptr<const PhaseTable> Get(int up, int down,
+	                                             int zeroCrossings,
+	                                             bool singlePhase);
+};
+
+
+/**
+ * @brief Streaming polyphase resampler for rational ratios.
+ *
+ * The ratio is derived from the input sampling frequency and the
+ * configured target frequency, e.g. 50 Hz to 40 Hz results in up = 4 and
+ * down = 5. Only the output samples are computed, there are no
+ * multiplications with inserted zeros and no discarded samples.
+ *
+ * As an InPlaceFilter the sample count cannot change. The registered
+ * filter "RESAMPLE(fout[,zc])" therefore applies the anti-alias low-pass
+ * of the ratio at the input rate which yields the same band limitation
+ * as the resampled trace. The actual rate conversion is available
+ * through resample().
+ *
+ * The delay lines are part of the filter snapshot, see StatefulFilter.
+ */
+template <typename T>
+class PolyphaseResampler : public StatefulFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		PolyphaseResampler(double targetFrequency = 0.0, int zeroCrossings = 10);
+
+		//! D'tor
+		~PolyphaseResampler() override;
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void setSamplingFrequency(double fsamp) override;
+		int setParameters(int n, const double *params) override;
+		void apply(int n, T *inout) override;
+		Seiscomp::Math::Filtering::InPlaceFilter<T>* clone() const override;
+
+
+	// ------------------------------------------------------------------
+	//  Public StatefulFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void reset() override;
+
+
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief Resamples a block of input samples to the target rate.
+		 * Consecutive calls continue the stream seamlessly.
+		 * @param n The number of input samples
+		 * @param in The input samples
+		 * @param out The output vector the resampled samples are appended to
+		 * @return The number of appended samples
+		 */
+		size_t resample(int n, const T *in, std::vector<T> &out);
+
+		int upFactor() const { return _up; }
+		int downFactor() const { return _down; }
+		double targetFrequency() const { return _targetFrequency; }
+
+
+	// ------------------------------------------------------------------
+	//  Protected StatefulFilter interface
+	// ------------------------------------------------------------------
+	protected:
+		std::string signature() const override;
+		void saveState(StateWriter &writer) const override;
+		bool restoreState(StateReader &reader) override;
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		struct Delay {
+			std::vector<T> buffer;
+			int            length{0};
+			int            head{0};
+
+			void reset(int n);
+			void fill(T value);
+			//! Pushes a sample and returns the last length samples
+			const T *push(T x);
+			void save(StateWriter &writer) const;
+			bool restore(StateReader &reader);
+		};
+
+		//! Restores the snapshot or primes the delay lines
+		void prepare(T first);
+
+		using TablePtr = std::shared_ptr<const PhaseTable<T>>;
+
+		double   _targetFrequency;
+		int      _zeroCrossings;
+		double   _fsamp{0};
+		bool     _restorePending{false};
+		bool     _primePending{false};
+		int      _up{1};
+		int      _down{1};
+		int      _phase{0};
+		TablePtr _table;
+		TablePtr _antiAlias;
+		Delay    _history;
+		Delay    _inplaceHistory;
+
+		ThroughputCounter _counter;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,246 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/system/application.h>
+#include <seiscomp/system/environment.h>
+
+#include "snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace FilterSimple {
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+// File layout, all integers in host byte order:
+//   char[4] magic, uint32 version, uint32 count,
+//   count x { uint32 keyLength, key, uint32 dataLength, data }
+const char Magic[4] = { 'S', 'C', 'F', 'S' };
+constexpr uint32_t Version = 1;
+
+
+}
+
+
+struct SnapshotStore::Impl {
+	using Region = pair<const char*, size_t>;
+
+	mutex                          access;
+	bool                           fileLoaded{false};
+	string                         path;
+	void                          *mapping{nullptr};
+	size_t                         mappingSize{0};
+	unordered_map<string, Region>  loaded;
+	map<string, vector<char>>      stored;
+};
+
+
+SnapshotStore &SnapshotStore::Instance() {
+	static SnapshotStore instance;
+	return instance;
+}
+
+
+SnapshotStore::~SnapshotStore() {
+	if ( !_impl ) {
+		return;
+	}
+
+	// Called on process exit after all filters are gone. Logging might
+	// not be available anymore.
+	save();
+
+	if ( _impl->mapping ) {
+		munmap(_impl->mapping, _impl->mappingSize);
+	}
+
+	delete _impl;
+}
+
+
+bool SnapshotStore::enabled() {
+	call_once(_initialized, &SnapshotStore::init, this);
+	return !_impl->path.empty();
+}
+
+
+void SnapshotStore::init() {
+	_impl = new Impl;
+
+	auto *app = System::Application::Instance();
+	if ( !app ) {
+		return;
+	}
+
+	try {
+		_impl->path = Environment::Instance()->absolutePath(
+			app->configGetString("filterSimple.snapshot")
+		);
+	}
+	catch ( ... ) {}
+}
+
+
+void SnapshotStore::load() {
+	// Called with the lock held
+	_impl->fileLoaded = true;
+
+	int fd = open(_impl->path.c_str(), O_RDONLY);
+	if ( fd < 0 ) {
+		SEISCOMP_DEBUG("No filter snapshot found at %s", _impl->path);
+		return;
+	}
+
+	struct stat st;
+	if ( fstat(fd, &st) != 0 || st.st_size < 12 ) {
+		close(fd);
+		return;
+	}
+
+	void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if ( mapping == MAP_FAILED ) {
+		SEISCOMP_WARNING("Failed to map filter snapshot %s", _impl->path);
+		return;
+	}
+
+	_impl->mapping = mapping;
+	_impl->mappingSize = st.st_size;
+
+	const char *cursor = static_cast<const char*>(mapping);
+	const char *end = cursor + st.st_size;
+	uint32_t version, count;
+
+	memcpy(&version, cursor + 4, 4);
+	memcpy(&count, cursor + 8, 4);
+
+	if ( memcmp(cursor, Magic, 4) != 0 || version != Version ) {
+		SEISCOMP_WARNING("%s: invalid filter snapshot", _impl->path);
+		return;
+	}
+
+	cursor += 12;
+
+	// Only the index is built, the states remain in the mapping
+	for ( uint32_t i = 0; i < count; ++i ) {
+		uint32_t keyLength, dataLength;
+
+		if ( end - cursor < 4 ) break;
+		memcpy(&keyLength, cursor, 4);
+		cursor += 4;
+		if ( size_t(end - cursor) < keyLength ) break;
+		string key(cursor, keyLength);
+		cursor += keyLength;
+
+		if ( end - cursor < 4 ) break;
+		memcpy(&dataLength, cursor, 4);
+		cursor += 4;
+		if ( size_t(end - cursor) < dataLength ) break;
+		_impl->loaded[key] = Impl::Region(cursor, dataLength);
+		cursor += dataLength;
+	}
+
+	SEISCOMP_INFO("Loaded %d filter states from %s",
+	              _impl->loaded.size(), _impl->path);
+}
+
+
+void SnapshotStore::save() const {
+	if ( _impl->path.empty() || _impl->stored.empty() ) {
+		return;
+	}
+
+	// Write to a temporary file and replace the snapshot atomically, the
+	// old file might still be mapped.
+	string tmp = _impl->path + ".tmp";
+	FILE *fp = fopen(tmp.c_str(), "wb");
+	if ( !fp ) {
+		return;
+	}
+
+	uint32_t count = static_cast<uint32_t>(_impl->stored.size());
+	bool ok = fwrite(Magic, 4, 1, fp) == 1
+	       && fwrite(&Version, 4, 1, fp) == 1
+	       && fwrite(&count, 4, 1, fp) == 1;
+
+	for ( auto it = _impl->stored.begin(); ok && it != _impl->stored.end(); ++it ) {
+		uint32_t keyLength = static_cast<uint32_t>(it->first.size());
+		uint32_t dataLength = static_cast<uint32_t>(it->second.size());
+		ok = fwrite(&keyLength, 4, 1, fp) == 1
+		  && fwrite(it->first.data(), 1, keyLength, fp) == keyLength
+		  && fwrite(&dataLength, 4, 1, fp) == 1
+		  && fwrite(it->second.data(), 1, dataLength, fp) == dataLength;
+	}
+
+	ok = (fclose(fp) == 0) && ok;
+
+	if ( !ok || rename(tmp.c_str(), _impl->path.c_str()) != 0 ) {
+		unlink(tmp.c_str());
+	}
+}
+
+
+bool SnapshotStore::take(const string &key, const char *&data, size_t &size) {
+	lock_guard<mutex> lock(_impl->access);
+	if ( !_impl->fileLoaded ) {
+		load();
+	}
+
+	auto it = _impl->loaded.find(key);
+	if ( it == _impl->loaded.end() ) {
+		return false;
+	}
+
+	data = it->second.first;
+	size = it->second.second;
+	_impl->loaded.erase(it);
+	return true;
+}
+
+
+void SnapshotStore::store(const string &key, vector<char> &&data) {
+	lock_guard<mutex> lock(_impl->access);
+	_impl->stored[key] = std::move(data);
+}
+
+
+void SnapshotStore::setPath(const string &path) {
+	call_once(_initialized, &SnapshotStore::init, this);
+	lock_guard<mutex> lock(_impl->access);
+	_impl->path = path;
+}
+
+
+}
@@ -0,0 +1,275 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_FILTERSIMPLE_SNAPSHOT_H
+#define SEISCOMP_TEMPLATES_FILTERSIMPLE_SNAPSHOT_H
+
+
+#include <seiscomp/core/datetime.h>
+#include <seiscomp/math/filter.h>
+
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace FilterSimple {
+
+
+/**
+ * @brief Appends plain values to a binary state buffer.
+ */
+class StateWriter {
+	public:
+		explicit StateWriter(std::vector<char> &buffer) : _buffer(buffer) {}
+
+		template <typename V>
+		void write(const V *values, size_t n) {
+			static_assert(std::is_trivially_copyable<V>::value, "POD required");
+			auto bytes = reinterpret_cast<const char*>(values);
+			_buffer.insert(_buffer.end(), bytes, bytes + n * sizeof(V));
+		}
+
+		template <typename V>
+		void write(const V &value) { write(&value, 1); }
+
+	private:
+		std::vector<char> &_buffer;
+};
+
+
+/**
+ * @brief Reads plain values from a binary state buffer, e.g. a region
+ *        of a memory mapped snapshot file.
+ */
+class StateReader {
+	public:
+		StateReader(const char *data, size_t size)
+		: _data(data), _end(data + size) {}
+
+		template <typename V>
+		bool read(V *values, size_t n) {
+			static_assert(std::is_trivially_copyable<V>::value, "POD required");
+			size_t size = n * sizeof(V);
+			if ( size_t(_end - _data) < size ) {
+				return false;
+			}
+			memcpy(values, _data, size);
+			_data += size;
+			return true;
+		}
+
+		template <typename V>
+		bool read(V &value) { return read(&value, 1); }
+
+		bool atEnd() const { return _data == _end; }
+
+	private:
+		const char *_data;
+		const char *_end;
+};
+
+
+/**
+ * @brief Process wide storage of filter states.
+ *
+ * If `filterSimple.snapshot` is configured, the snapshot file is memory
+ * mapped on first use and each stored state can be taken exactly once.
+ * States stored by the filters are written to that file when the
+ * process exits.
+ *
+ * The file is written only on a regular exit. Filters store their state
+ * from their destructors, there is no periodic flush because the state
+ * of a filter cannot be read while another thread applies it. After a
+ * crash the file of the previous run remains, its states do not continue
+ * the new data and the filters start from scratch.
+ */
+class SnapshotStore {
+	public:
+		static SnapshotStore &Instance();
+
+		~SnapshotStore();
+
+	public:
+		//! Returns whether a snapshot file is configured
+		bool enabled();
+
+		/**
+		 * @brief Takes a state from the loaded snapshot.
+		 * @param key The state key
+		 * @param data The address of the state inside the mapping
+		 * @param size The size of the state in bytes
+		 * @return false if no state exists for the key
+		 */
+		bool take(const std::string &key, const char *&data, size_t &size);
+
+		//! Stores a state which is written on exit
+		void store(const std::string &key, std::vector<char> &&data);
+
+		/**
+		 * @brief Sets the snapshot file of processes without application
+		 *        configuration, e.g. tools and tests. It must be called
+		 *        before the first filter is applied. An empty path
+		 *        disables the store.
+		 */
+		void setPath(const std::string &path);
+
+	private:
+		SnapshotStore() = default;
+		void init();
+		void load();
+		void save() const;
+
+	private:
+		struct Impl;
+		std::once_flag _initialized;
+		Impl          *_impl{nullptr};
+};
+
+
+/**
+ * @brief Base class of filters whose state survives a process restart
+ *        and which can be reset cheaply after gaps.
+ *
+ * A derived filter calls restoreSnapshot() before it processes its first
+ * sample and storeSnapshot() from its destructor. A state is only
+ * restored if the snapshot was taken for the same stream, the same
+ * filter signature and sampling frequency and if the new data continue
+ * the data at the time the snapshot was taken.
+ *
+ * After reset() a derived filter initialises its state from the next
+ * sample as if a constant signal of that value had been fed forever,
+ * like lfilter_zi in scipy. A step at the start of a segment therefore
+ * causes no transient. If a new start time does not continue the data
+ * processed so far, the filter resets itself, a clone is not required.
+ */
+template <typename T>
+class StatefulFilter : public Seiscomp::Math::Filtering::InPlaceFilter<T> {
+	public:
+		void setStartTime(const Seiscomp::Core::Time &time) override {
+			double startTime = static_cast<double>(time);
+
+			if ( _samples && _fsamp > 0
+			  && std::fabs(_startTime + _samples / _fsamp - startTime) <= 0.5 / _fsamp ) {
+				// Continuous data, keep the state
+				return;
+			}
+
+			if ( _samples ) {
+				reset();
+			}
+
+			_startTime = startTime;
+			_samples = 0;
+		}
+
+		void setStreamID(const std::string &net, const std::string &sta,
+		                 const std::string &loc, const std::string &cha) override {
+			_streamID = net + "." + sta + "." + loc + "." + cha;
+		}
+
+		/**
+		 * @brief Drops the current state. This is much cheaper than
+		 *        clone() as all tables and buffers are kept.
+		 */
+		virtual void reset() = 0;
+
+
+	protected:
+		//! Returns the filter name and its parameters, e.g. "MEDIAN(1,0)"
+		virtual std::string signature() const = 0;
+		virtual void saveState(StateWriter &writer) const = 0;
+		virtual bool restoreState(StateReader &reader) = 0;
+
+		//! Counts processed samples to derive the time of the next sample
+		void advance(int n) { _samples += n; }
+
+		//! Sets the sampling frequency used to check the continuity
+		void setStateSamplingFrequency(double fsamp) { _fsamp = fsamp; }
+
+		//! Takes the snapshot state, only the first call per filter
+		//! instance looks into the snapshot.
+		bool restoreSnapshot(double fsamp) {
+			if ( _snapshotChecked ) {
+				return false;
+			}
+
+			_snapshotChecked = true;
+
+			if ( _streamID.empty() || _startTime == 0 || fsamp <= 0 ) {
+				return false;
+			}
+
+			auto &store = SnapshotStore::Instance();
+			const char *data;
+			size_t size;
+			if ( !store.enabled() || !store.take(key(), data, size) ) {
+				return false;
+			}
+
+			StateReader reader(data, size);
+			double snapshotFsamp, nextTime;
+			if ( !reader.read(snapshotFsamp) || !reader.read(nextTime) ) {
+				return false;
+			}
+
+			// Only continuous data may continue with the old state
+			if ( snapshotFsamp != fsamp
+			  || std::fabs(nextTime - _startTime) > 0.5 / fsamp ) {
+				return false;
+			}
+
+			return restoreState(reader) && reader.atEnd();
+		}
+
+		void storeSnapshot(double fsamp) const {
+			if ( _streamID.empty() || _startTime == 0 || fsamp <= 0 || !_samples ) {
+				return;
+			}
+
+			auto &store = SnapshotStore::Instance();
+			if ( !store.enabled() ) {
+				return;
+			}
+
+			std::vector<char> data;
+			StateWriter writer(data);
+			writer.write(fsamp);
+			writer.write(_startTime + _samples / fsamp);
+			saveState(writer);
+			store.store(key(), std::move(data));
+		}
+
+
+	private:
+		std::string key() const { return _streamID + "|" + signature(); }
+
+
+	private:
+		std::string _streamID;
+		double      _startTime{0};
+		double      _fsamp{0};
+		long long   _samples{0};
+		bool        _snapshotChecked{false};
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,175 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/system/application.h>
+
+#include "statistics.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+
+
+namespace FilterSimple {
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+#if defined(__x86_64__) || defined(__i386__)
+const char *TickUnit = "cycles";
+#else
+const char *TickUnit = "ns";
+#endif
+
+
+int64_t now() {
+	return chrono::duration_cast<chrono::nanoseconds>(
+		chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+
+struct Registry {
+	struct Entry {
+		ThroughputStats stats;
+		uint64_t        lastCalls{0};
+		uint64_t        lastSamples{0};
+		uint64_t        lastTicks{0};
+	};
+
+	once_flag                           initialized;
+	int64_t                             interval{0};
+	atomic<int64_t>                     nextReport{0};
+	mutex                               access;
+	map<string, unique_ptr<Entry>>      entries;
+
+	void init() {
+		auto *app = System::Application::Instance();
+		if ( !app ) {
+			return;
+		}
+
+		try {
+			interval = static_cast<int64_t>(
+				app->configGetDouble("filterSimple.statistics.interval") * 1E9
+			);
+		}
+		catch ( ... ) {}
+
+		if ( interval > 0 ) {
+			nextReport = now() + interval;
+			SEISCOMP_INFO("Filter statistics are reported every %g s",
+			              interval * 1E-9);
+		}
+	}
+};
+
+
+Registry &registry() {
+	static Registry instance;
+	call_once(instance.initialized, &Registry::init, &instance);
+	return instance;
+}
+
+
+}
+
+
+string makeSignature(const char *name, initializer_list<double> params) {
+	string sig(name);
+	char buf[32];
+	sig += '(';
+	for ( auto it = params.begin(); it != params.end(); ++it ) {
+		snprintf(buf, sizeof(buf), it == params.begin() ? "%.17g" : ",%.17g", *it);
+		sig += buf;
+	}
+	sig += ')';
+	return sig;
+}
+
+
+ThroughputStats *throughputStats(const string &signature) {
+	auto &reg = registry();
+	if ( reg.interval <= 0 ) {
+		return nullptr;
+	}
+
+	lock_guard<mutex> lock(reg.access);
+	auto &entry = reg.entries[signature];
+	if ( !entry ) {
+		entry.reset(new Registry::Entry);
+	}
+
+	return &entry->stats;
+}
+
+
+void reportThroughput() {
+	auto &reg = registry();
+	int64_t t = now();
+	int64_t next = reg.nextReport.load(memory_order_relaxed);
+
+	// Only one thread reports per interval
+	if ( t < next
+	  || !reg.nextReport.compare_exchange_strong(next, t + reg.interval) ) {
+		return;
+	}
+
+	double seconds = (t - next + reg.interval) * 1E-9;
+
+	lock_guard<mutex> lock(reg.access);
+	for ( auto &item : reg.entries ) {
+		auto &entry = *item.second;
+		uint64_t calls = entry.stats.calls.load(memory_order_relaxed);
+		uint64_t samples = entry.stats.samples.load(memory_order_relaxed);
+		uint64_t ticks = entry.stats.ticks.load(memory_order_relaxed);
+
+		uint64_t dSamples = samples - entry.lastSamples;
+		uint64_t dTicks = ticks - entry.lastTicks;
+
+		SEISCOMP_INFO("%s: %d instances, %d calls, %d samples, "
+		              "%.0f samples/s, %.2f %s/sample",
+		              item.first, entry.stats.instances.load(),
+		              calls - entry.lastCalls, dSamples,
+		              dSamples / seconds,
+		              dSamples ? double(dTicks) / dSamples : 0.0, TickUnit);
+
+		entry.lastCalls = calls;
+		entry.lastSamples = samples;
+		entry.lastTicks = ticks;
+	}
+}
+
+
+void ThroughputCounter::bindSignature(const char *name,
+                                      initializer_list<double> params) {
+	_bound = true;
+	_stats = throughputStats(makeSignature(name, params));
+	if ( _stats ) {
+		++_stats->instances;
+	}
+}
+
+
+}
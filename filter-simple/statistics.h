@@ -0,0 +1,158 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_FILTERSIMPLE_STATISTICS_H
+#define SEISCOMP_TEMPLATES_FILTERSIMPLE_STATISTICS_H
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+namespace FilterSimple {
+
+
+//! Returns the current CPU time stamp counter or the monotonic clock in
+//! nanoseconds if the platform has no accessible counter.
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+#endif
+}
+
+
+/**
+ * @brief Throughput of all filter instances with the same signature,
+ *        e.g. "MEDIAN(5,0)".
+ */
+struct ThroughputStats {
+	std::atomic<uint64_t> instances{0};
+	std::atomic<uint64_t> calls{0};
+	std::atomic<uint64_t> samples{0};
+	std::atomic<uint64_t> ticks{0};
+};
+
+
+//! Formats a filter name and its parameters, e.g. "MEDIAN(1,0)"
+std::string makeSignature(const char *name, std::initializer_list<double> params);
+
+
+/**
+ * @brief Returns the aggregate of a filter signature.
+ * If `filterSimple.statistics.interval` is not configured or zero,
+ * nullptr is returned and the counters cost a single branch per apply().
+ */
+ThroughputStats *throughputStats(const std::string &signature);
+
+//! Logs all aggregates if the configured interval has passed
+void reportThroughput();
+
+
+/**
+ * @brief Per instance counters which are bound lazily to the aggregate of
+ *        the filter signature.
+ */
+class ThroughputCounter {
+	public:
+		ThroughputCounter() = default;
+		ThroughputCounter(const ThroughputCounter &) = delete;
+		ThroughputCounter &operator=(const ThroughputCounter &) = delete;
+
+		~ThroughputCounter() {
+			if ( _stats ) {
+				--_stats->instances;
+			}
+		}
+
+	public:
+		//! Returns the aggregate or nullptr if statistics are disabled
+		ThroughputStats *bind(const char *name, std::initializer_list<double> params) {
+			if ( !_bound ) {
+				bindSignature(name, params);
+			}
+			return _stats;
+		}
+
+		void add(int n, uint64_t t) {
+			_samples += n;
+			_ticks += t;
+			_stats->calls.fetch_add(1, std::memory_order_relaxed);
+			_stats->samples.fetch_add(n, std::memory_order_relaxed);
+			_stats->ticks.fetch_add(t, std::memory_order_relaxed);
+		}
+
+		uint64_t samples() const { return _samples; }
+		uint64_t ticks() const { return _ticks; }
+
+	private:
+		void bindSignature(const char *name, std::initializer_list<double> params);
+
+	private:
+		ThroughputStats *_stats{nullptr};
+		bool             _bound{false};
+		uint64_t         _samples{0};
+		uint64_t         _ticks{0};
+};
+
+
+/**
+ * @brief Measures a single apply() call.
+ *
+ * @code
+ * ThroughputScope scope(_counter, "MEDIAN", { _length, _threshold }, n);
+ * @endcode
+ */
+class ThroughputScope {
+	public:
+		ThroughputScope(ThroughputCounter &counter, const char *name,
+		                std::initializer_list<double> params, int n)
+		: _counter(counter.bind(name, params) ? &counter : nullptr), _n(n) {
+			if ( _counter ) {
+				_start = FilterSimple::ticks();
+			}
+		}
+
+		~ThroughputScope() {
+			if ( _counter ) {
+				_counter->add(_n, FilterSimple::ticks() - _start);
+				reportThroughput();
+			}
+		}
+
+		ThroughputScope(const ThroughputScope &) = delete;
+		ThroughputScope &operator=(const ThroughputScope &) = delete;
+
+	private:
+		ThroughputCounter *_counter;
+		int                _n;
+		uint64_t           _start{0};
+};
+
+
+}
+
+
+#endif
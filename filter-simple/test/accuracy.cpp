@@ -0,0 +1,148 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/math/filter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 100;
+constexpr int Samples = 100000;
+// Samples per apply() call as delivered by a typical SeedLink stream
+constexpr int RecordLength = 512;
+// The limits of the relative deviations, see README.md for the measured
+// values
+constexpr double FloatLimit = 5E-7;
+constexpr double TableLimit = 1E-7;
+
+
+template <typename T>
+bool run(const string &filter, const vector<double> &input, vector<double> &output) {
+	unique_ptr<Math::Filtering::InPlaceFilter<T>> f(
+		Math::Filtering::InPlaceFilter<T>::Create(filter)
+	);
+	if ( !f ) {
+		cerr << "Could not create " << filter << endl;
+		return false;
+	}
+
+	f->setSamplingFrequency(SamplingFrequency);
+
+	vector<T> data(input.begin(), input.end());
+	for ( int i = 0; i < Samples; i += RecordLength ) {
+		f->apply(min(RecordLength, Samples - i), data.data() + i);
+	}
+
+	output.assign(data.begin(), data.end());
+	return true;
+}
+
+
+//! Returns the maximum deviation relative to the peak of the reference
+double deviation(const vector<double> &values, const vector<double> &reference) {
+	double peak = 0, error = 0;
+	for ( size_t i = 0; i < reference.size(); ++i ) {
+		peak = max(peak, abs(reference[i]));
+		error = max(error, abs(values[i] - reference[i]));
+	}
+	return peak > 0 ? error / peak : error;
+}
+
+
+struct Case {
+	//! The filter under test
+	string filter;
+	//! The double precision filter which computes the reference
+	string reference;
+	//! The maximum relative deviation of the double variant
+	double doubleLimit;
+	//! The maximum relative deviation of the float variant
+	double floatLimit;
+};
+
+
+}
+
+
+/**
+ * Compares the float variants of the filters of this plugin with their
+ * double variants, and the lookup table variant of POLY with the exact
+ * polynomial. The input is noise in the range of a 24-bit digitizer.
+ */
+int main() {
+	mt19937 rng(42);
+	normal_distribution<double> noise(0, 1E6);
+	vector<double> input(Samples);
+	for ( auto &v : input ) {
+		v = max(-8E6, min(8E6, noise(rng)));
+	}
+
+	// A few spikes for the despiking
+	for ( int i = 1000; i < Samples; i += 10000 ) {
+		input[i] = 8E6;
+	}
+
+	const Case cases[] = {
+		{ "SIMPLE(1.5,100)", "SIMPLE(1.5,100)", 0, FloatLimit },
+		{ "POLY(0,1,-2E-8)", "POLY(0,1,-2E-8)", 0, FloatLimit },
+		{ "POLY(10,1,1E-8,-1E-15)", "POLY(10,1,1E-8,-1E-15)", 0, FloatLimit },
+		{ "POLYLUT(-8E6,8E6,0,1,-2E-8)", "POLY(0,1,-2E-8)", TableLimit, FloatLimit },
+		{ "POLYLUT(-8E6,8E6,10,1,1E-8,-1E-15)", "POLY(10,1,1E-8,-1E-15)", TableLimit, FloatLimit },
+		{ "LOGC(1E-3)", "LOGC(1E-3)", 0, FloatLimit },
+		{ "RESAMPLE(40)", "RESAMPLE(40)", 0, FloatLimit },
+		{ "MEDIAN(1,5000)", "MEDIAN(1,5000)", 0, FloatLimit }
+	};
+
+	bool ok = true;
+
+	cout << left << setw(36) << "filter" << setw(14) << "double" << "float" << endl;
+
+	for ( const auto &c : cases ) {
+		vector<double> reference, doubleOutput, floatOutput;
+		if ( !run<double>(c.reference, input, reference)
+		  || !run<double>(c.filter, input, doubleOutput)
+		  || !run<float>(c.filter, input, floatOutput) ) {
+			ok = false;
+			continue;
+		}
+
+		double doubleDeviation = deviation(doubleOutput, reference);
+		double floatDeviation = deviation(floatOutput, reference);
+
+		cout << setw(36) << c.filter << scientific << setprecision(2)
+		     << setw(14) << doubleDeviation << floatDeviation << endl;
+
+		if ( doubleDeviation > c.doubleLimit || floatDeviation > c.floatLimit ) {
+			cerr << c.filter << " exceeds the deviation limit" << endl;
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
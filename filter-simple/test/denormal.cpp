@@ -0,0 +1,153 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/math/filter.h>
+
+#include "denormal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr int Samples = 200000;
+constexpr int Repetitions = 5;
+
+
+/**
+ * @brief A second order Butterworth low-pass in direct form I like the
+ *        sections of the recursive filters in SeisComP.
+ */
+struct Biquad {
+	double b0, b1, b2, a1, a2;
+	double x1{0}, x2{0}, y1{0}, y2{0};
+
+	explicit Biquad(double corner) {
+		double k = tan(M_PI * corner);
+		double q = M_SQRT1_2;
+		double norm = 1.0 / (1.0 + k / q + k * k);
+		b0 = k * k * norm;
+		b1 = 2 * b0;
+		b2 = b0;
+		a1 = 2 * (k * k - 1) * norm;
+		a2 = (1 - k / q + k * k) * norm;
+	}
+
+	void apply(int n, double *data) {
+		for ( int i = 0; i < n; ++i ) {
+			double y = b0 * data[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+			x2 = x1; x1 = data[i];
+			y2 = y1; y1 = y;
+			data[i] = y;
+		}
+	}
+};
+
+
+/**
+ * @brief Returns the minimum time in seconds of several runs of a
+ *        processing function on a copy of the data.
+ */
+template <typename Process>
+double measure(const vector<double> &input, Process process) {
+	double best = 1E300;
+
+	for ( int r = 0; r < Repetitions; ++r ) {
+		vector<double> data(input);
+		auto start = chrono::steady_clock::now();
+		process(data);
+		best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	}
+
+	return best;
+}
+
+
+// A corner of 1E-5 of the sampling rate, e.g. 1 mHz at 100 Hz, decays so
+// slowly that the states stay subnormal during the whole run.
+Biquad silentFilter() {
+	Biquad filter(1E-5);
+	filter.y1 = filter.y2 = 1E-310;
+	return filter;
+}
+
+
+}
+
+
+/**
+ * Reproduces the slowdown of a recursive filter whose states decayed into
+ * the subnormal range during silence and measures the processing time of
+ * silence with DenormalGuard and with DITHER in front of the filter
+ * relative to loud data.
+ *
+ * Usage: bench_tmplfilter_denormal
+ */
+int main() {
+	mt19937 rng(42);
+	normal_distribution<double> noise(0, 1000);
+	vector<double> loud(Samples), silence(Samples, 0.0);
+	for ( auto &v : loud ) {
+		v = noise(rng);
+	}
+
+	double loudTime = measure(loud, [](vector<double> &data) {
+		Biquad(1E-5).apply(Samples, data.data());
+	});
+
+	double unprotectedTime = measure(silence, [](vector<double> &data) {
+		silentFilter().apply(Samples, data.data());
+	});
+
+	double guardedTime = measure(silence, [](vector<double> &data) {
+		FilterSimple::DenormalGuard guard;
+		silentFilter().apply(Samples, data.data());
+	});
+
+	unique_ptr<Math::Filtering::InPlaceFilter<double>> dither(
+		Math::Filtering::InPlaceFilter<double>::Create("DITHER")
+	);
+	if ( !dither ) {
+		cerr << "DITHER is not registered" << endl;
+		return 1;
+	}
+
+	double ditheredTime = measure(silence, [&dither](vector<double> &data) {
+		dither->apply(Samples, data.data());
+		silentFilter().apply(Samples, data.data());
+	});
+
+	cout << "loud data:             " << loudTime * 1E9 / Samples << " ns/sample" << endl;
+	cout << "subnormal states:      " << unprotectedTime * 1E9 / Samples << " ns/sample ("
+	     << unprotectedTime / loudTime << "x)" << endl;
+	cout << "with DenormalGuard:    " << guardedTime * 1E9 / Samples << " ns/sample ("
+	     << guardedTime / loudTime << "x)" << endl;
+	// The dithered time includes DITHER itself
+	cout << "with DITHER:           " << ditheredTime * 1E9 / Samples << " ns/sample ("
+	     << ditheredTime / loudTime << "x)" << endl;
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/math/filter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 200;
+// Samples per apply() call as delivered by a typical SeedLink stream
+constexpr int RecordLength = 512;
+
+
+double seconds(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+//! Runs the registered MEDIAN filter and returns the elapsed time
+double median(const string &filter, vector<double> data) {
+	unique_ptr<Math::Filtering::InPlaceFilter<double>> f(
+		Math::Filtering::InPlaceFilter<double>::Create(filter)
+	);
+	if ( !f ) {
+		cerr << "Could not create " << filter << endl;
+		exit(1);
+	}
+
+	f->setSamplingFrequency(SamplingFrequency);
+
+	auto start = chrono::steady_clock::now();
+	for ( size_t i = 0; i + RecordLength <= data.size(); i += RecordLength ) {
+		f->apply(RecordLength, data.data() + i);
+	}
+	return seconds(start);
+}
+
+
+//! Selects the median of each window from scratch and returns the
+//! elapsed time, the approach of a naive implementation
+double naive(int windowSize, vector<double> data) {
+	vector<double> window(windowSize, data[0]), scratch(windowSize);
+	size_t head = 0;
+
+	auto start = chrono::steady_clock::now();
+	for ( auto &v : data ) {
+		window[head] = v;
+		if ( ++head == window.size() ) {
+			head = 0;
+		}
+
+		scratch = window;
+		nth_element(scratch.begin(), scratch.begin() + windowSize / 2, scratch.end());
+		v = scratch[windowSize / 2];
+	}
+	return seconds(start);
+}
+
+
+}
+
+
+/**
+ * Measures the throughput of MEDIAN for windows of several seconds at
+ * 200 Hz, with and without despiking, and compares it with selecting the
+ * median of each window from scratch.
+ *
+ * Usage: bench_tmplfilter_median [duration in s, default 600]
+ */
+int main(int argc, char **argv) {
+	double duration = argc > 1 ? atof(argv[1]) : 600;
+	if ( duration <= 0 ) {
+		cerr << "Invalid duration: " << argv[1] << endl;
+		return 1;
+	}
+
+	mt19937 rng(42);
+	normal_distribution<double> noise(0, 1000);
+	vector<double> data(static_cast<size_t>(duration * SamplingFrequency));
+	for ( auto &v : data ) {
+		v = noise(rng);
+	}
+
+	cout << "window   MEDIAN       despike      naive        speedup" << endl;
+	cout << "[s]      [MS/s]       [MS/s]       [MS/s]" << endl;
+
+	for ( double length : { 1.0, 2.0, 5.0, 10.0 } ) {
+		int windowSize = 2 * static_cast<int>(length * SamplingFrequency * 0.5) + 1;
+		string args = to_string(length);
+
+		double medianTime = median("MEDIAN(" + args + ")", data);
+		double despikeTime = median("MEDIAN(" + args + ",5000)", data);
+		double naiveTime = naive(windowSize, data);
+
+		cout << fixed << setprecision(0) << setw(6) << length
+		     << setprecision(2)
+		     << setw(11) << data.size() / medianTime * 1E-6
+		     << setw(13) << data.size() / despikeTime * 1E-6
+		     << setw(13) << data.size() / naiveTime * 1E-6
+		     << setw(13) << naiveTime / medianTime << "x" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include <seiscomp/core/genericrecord.h>
+#include <seiscomp/core/typedarray.h>
+#include <seiscomp/math/filter.h>
+
+#include "pipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 100;
+constexpr int RecordLength = 100;
+constexpr int Producers = 4;
+constexpr int StreamsPerProducer = 3;
+constexpr int RecordsPerStream = 30;
+// The record of the first stream of each producer which follows a gap
+constexpr int GapRecord = 15;
+constexpr double Gap = 5;
+const double StartTime = 1700000000.0;
+
+const char *Filter = "MEDIAN(0.5)";
+
+
+struct Stream {
+	string         station;
+	vector<double> data;
+	vector<double> startTimes;
+};
+
+
+vector<Stream> createStreams() {
+	vector<Stream> streams(Producers * StreamsPerProducer);
+	mt19937 rng(11);
+	normal_distribution<double> noise(0, 1E6);
+
+	for ( size_t i = 0; i < streams.size(); ++i ) {
+		auto &stream = streams[i];
+		stream.station = "S" + to_string(i);
+		stream.data.resize(RecordsPerStream * RecordLength);
+		for ( auto &v : stream.data ) {
+			v = noise(rng);
+		}
+
+		double time = StartTime;
+		for ( int r = 0; r < RecordsPerStream; ++r ) {
+			if ( i % StreamsPerProducer == 0 && r == GapRecord ) {
+				time += Gap;
+			}
+			stream.startTimes.push_back(time);
+			time += RecordLength / SamplingFrequency;
+		}
+	}
+
+	return streams;
+}
+
+
+RecordCPtr createRecord(const Stream &stream, int index) {
+	GenericRecordPtr rec = new GenericRecord("XX", stream.station, "", "HHZ",
+	                                         Core::Time(stream.startTimes[index]),
+	                                         SamplingFrequency);
+	rec->setData(RecordLength, stream.data.data() + index * RecordLength, Array::DOUBLE);
+	return rec.get();
+}
+
+
+//! Filters a stream without the pipeline, a gap starts a new filter
+vector<double> expected(const Stream &stream) {
+	vector<double> data(stream.data);
+	unique_ptr<Math::Filtering::InPlaceFilter<double>> f;
+
+	for ( int r = 0; r < RecordsPerStream; ++r ) {
+		if ( r == 0 || stream.startTimes[r] != stream.startTimes[r-1] + RecordLength / SamplingFrequency ) {
+			f.reset(Math::Filtering::InPlaceFilter<double>::Create(Filter));
+			f->setSamplingFrequency(SamplingFrequency);
+		}
+		f->apply(RecordLength, data.data() + r * RecordLength);
+	}
+
+	return data;
+}
+
+
+/**
+ * Several producers feed the records of their streams interleaved. The
+ * records of each stream must be delivered in feed order and filtered
+ * like a single filter would do it.
+ */
+bool checkOrder() {
+	auto streams = createStreams();
+
+	mutex access;
+	map<string, vector<double>> outputs;
+	map<string, vector<double>> startTimes;
+
+	{
+		FilterSimple::FilterPipeline<double> pipeline(
+			Filter, 3, 8,
+			[&](GenericRecord *rec) {
+				auto *data = static_cast<const DoubleArray*>(rec->data());
+				lock_guard<mutex> lock(access);
+				auto &output = outputs[rec->stationCode()];
+				output.insert(output.end(), data->typedData(), data->typedData() + data->size());
+				startTimes[rec->stationCode()].push_back(double(rec->startTime()));
+			}
+		);
+
+		vector<thread> producers;
+		for ( int p = 0; p < Producers; ++p ) {
+			producers.emplace_back([&, p] {
+				for ( int r = 0; r < RecordsPerStream; ++r ) {
+					for ( int s = 0; s < StreamsPerProducer; ++s ) {
+						pipeline.feed(createRecord(streams[p * StreamsPerProducer + s], r).get());
+					}
+				}
+			});
+		}
+
+		for ( auto &producer : producers ) {
+			producer.join();
+		}
+
+		pipeline.flush();
+	}
+
+	bool ok = true;
+	for ( const auto &stream : streams ) {
+		if ( startTimes[stream.station] != stream.startTimes ) {
+			cerr << stream.station << ": records are not delivered in feed order" << endl;
+			ok = false;
+		}
+		else if ( outputs[stream.station] != expected(stream) ) {
+			cerr << stream.station << ": the output differs from a single filter" << endl;
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+
+/**
+ * A blocked callback stalls the only worker, feed() must block once
+ * maxPending records are pending and continue when the worker proceeds.
+ */
+bool checkBackPressure() {
+	constexpr size_t MaxPending = 4;
+	constexpr int Records = 10;
+
+	auto streams = createStreams();
+	mutex gateMutex;
+	condition_variable gateChanged;
+	bool open = false;
+	atomic<int> delivered{0};
+	atomic<int> fed{0};
+
+	FilterSimple::FilterPipeline<double> pipeline(
+		Filter, 1, MaxPending,
+		[&](GenericRecord *) {
+			unique_lock<mutex> lock(gateMutex);
+			gateChanged.wait(lock, [&] { return open; });
+			++delivered;
+		}
+	);
+
+	thread producer([&] {
+		for ( int r = 0; r < Records; ++r ) {
+			pipeline.feed(createRecord(streams[1], r).get());
+			++fed;
+		}
+	});
+
+	// The record in the callback counts as pending until it is delivered
+	this_thread::sleep_for(chrono::milliseconds(200));
+	int blockedAt = fed;
+
+	{
+		lock_guard<mutex> lock(gateMutex);
+		open = true;
+	}
+	gateChanged.notify_all();
+
+	producer.join();
+	pipeline.flush();
+
+	bool ok = true;
+	if ( blockedAt != int(MaxPending) ) {
+		cerr << "feed() returned " << blockedAt << " times with a stalled worker, "
+		     << "expected " << MaxPending << endl;
+		ok = false;
+	}
+
+	if ( delivered != Records ) {
+		cerr << delivered << " of " << Records << " records delivered" << endl;
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+}
+
+
+int main() {
+	bool ok = true;
+
+	bool orderOk = checkOrder();
+	cout << "order " << (orderOk ? "ok" : "failed") << endl;
+	ok = ok && orderOk;
+
+	bool backPressureOk = checkBackPressure();
+	cout << "back-pressure " << (backPressureOk ? "ok" : "failed") << endl;
+	ok = ok && backPressureOk;
+
+	return ok ? 0 : 1;
+}
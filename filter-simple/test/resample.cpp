@@ -0,0 +1,155 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/core/genericrecord.h>
+#include <seiscomp/core/typedarray.h>
+#include <seiscomp/io/recordfilter/resample.h>
+
+#include "resample.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+// Samples per record as delivered by a typical SeedLink stream
+constexpr int RecordLength = 512;
+
+
+struct Ratio {
+	double input;
+	double output;
+};
+
+
+double seconds(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * @brief Resamples the data with PolyphaseResampler::resample().
+ * @return The number of output samples
+ */
+size_t polyphase(const Ratio &ratio, const vector<double> &data, double &elapsed) {
+	FilterSimple::PolyphaseResampler<double> resampler(ratio.output);
+	resampler.setSamplingFrequency(ratio.input);
+
+	vector<double> out;
+	size_t count = 0;
+
+	auto start = chrono::steady_clock::now();
+	for ( size_t i = 0; i + RecordLength <= data.size(); i += RecordLength ) {
+		out.clear();
+		count += resampler.resample(RecordLength, data.data() + i, out);
+	}
+	elapsed = seconds(start);
+
+	return count;
+}
+
+
+/**
+ * @brief Resamples the data with the record resampler of SeisComP which
+ *        is used by the applications to resample streams.
+ * @return The number of output samples
+ */
+size_t recordResampler(const Ratio &ratio, const vector<double> &data, double &elapsed) {
+	IO::RecordResampler<double> resampler(ratio.output);
+
+	// Records are created upfront to only measure the resampling
+	vector<GenericRecordPtr> records;
+	Core::Time time(2024, 1, 1);
+	for ( size_t i = 0; i + RecordLength <= data.size(); i += RecordLength ) {
+		GenericRecordPtr rec = new GenericRecord("XX", "TEST", "", "HHZ", time, ratio.input);
+		rec->setData(RecordLength, data.data() + i, Array::DOUBLE);
+		records.push_back(rec);
+		time += Core::TimeSpan(RecordLength / ratio.input);
+	}
+
+	size_t count = 0;
+
+	auto start = chrono::steady_clock::now();
+	for ( const auto &rec : records ) {
+		RecordPtr out = resampler.feed(rec.get());
+		if ( out && out->data() ) {
+			count += out->data()->size();
+		}
+	}
+	elapsed = seconds(start);
+
+	return count;
+}
+
+
+}
+
+
+/**
+ * Compares the throughput of the polyphase resampler with the record
+ * resampler for the common rate conversions of a mixed rate network.
+ *
+ * Usage: bench_tmplfilter_resample [duration in s, default 3600]
+ */
+int main(int argc, char **argv) {
+	double duration = argc > 1 ? atof(argv[1]) : 3600;
+	if ( duration <= 0 ) {
+		cerr << "Invalid duration: " << argv[1] << endl;
+		return 1;
+	}
+
+	const Ratio ratios[] = {
+		{ 200, 100 }, { 200, 40 }, { 100, 50 }, { 100, 40 },
+		{ 50, 40 }, { 40, 20 }, { 20, 50 }
+	};
+
+	mt19937 rng(42);
+	normal_distribution<double> noise(0, 1000);
+
+	cout << "ratio          polyphase    record resampler  speedup" << endl;
+	cout << "               [MS/s]       [MS/s]" << endl;
+
+	for ( const auto &ratio : ratios ) {
+		vector<double> data(static_cast<size_t>(duration * ratio.input));
+		for ( auto &v : data ) {
+			v = noise(rng);
+		}
+
+		double polyphaseTime, recordTime;
+		size_t polyphaseCount = polyphase(ratio, data, polyphaseTime);
+		size_t recordCount = recordResampler(ratio, data, recordTime);
+
+		cout << defaultfloat << setprecision(6)
+		     << setw(4) << ratio.input << " -> " << setw(3) << ratio.output << " Hz  "
+		     << fixed << setprecision(2)
+		     << setw(9) << data.size() / polyphaseTime * 1E-6 << "    "
+		     << setw(9) << data.size() / recordTime * 1E-6 << "         "
+		     << setw(6) << recordTime / polyphaseTime << "x"
+		     << "   (" << polyphaseCount << " / " << recordCount << " samples)"
+		     << endl;
+	}
+
+	return 0;
+}
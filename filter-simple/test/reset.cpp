@@ -0,0 +1,174 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include <seiscomp/core/datetime.h>
+#include <seiscomp/math/filter.h>
+
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 100;
+constexpr int RecordLength = 512;
+constexpr int Records = 8;
+const double StartTime = 1700000000.0;
+// The maximum deviation from the steady state relative to the level of
+// a constant input
+constexpr double TransientLimit = 1E-9;
+
+const char *Filters[] = { "MEDIAN(1)", "MEDIAN(2,5000)", "RESAMPLE(40)", "RESAMPLE(20,4)" };
+
+
+using Filter = Math::Filtering::InPlaceFilter<double>;
+
+
+unique_ptr<Filter> create(const string &filter) {
+	unique_ptr<Filter> f(Filter::Create(filter));
+	if ( f ) {
+		f->setSamplingFrequency(SamplingFrequency);
+	}
+	return f;
+}
+
+
+vector<double> run(Filter *f, vector<double> data) {
+	for ( size_t i = 0; i < data.size(); i += RecordLength ) {
+		f->apply(min<int>(RecordLength, data.size() - i), data.data() + i);
+	}
+	return data;
+}
+
+
+vector<double> noise(unsigned int seed, double level) {
+	mt19937 rng(seed);
+	normal_distribution<double> dist(level, 1E5);
+	vector<double> data(Records * RecordLength);
+	for ( auto &v : data ) {
+		v = dist(rng);
+	}
+	return data;
+}
+
+
+//! The deviation from the last sample which is taken as the steady state,
+//! the DC gain of the anti-alias filters is not exactly one.
+double transient(const vector<double> &data, double level) {
+	double error = 0;
+	for ( auto v : data ) {
+		error = max(error, abs(v - data.back()));
+	}
+	return error / abs(level);
+}
+
+
+bool check(const string &filter) {
+	bool ok = true;
+	auto first = noise(1, 0);
+	auto second = noise(2, 3E6);
+	double secondTime = StartTime + first.size() / SamplingFrequency;
+
+	auto fresh = create(filter);
+	auto expected = run(fresh.get(), second);
+
+	// An explicit reset
+	auto f = create(filter);
+	run(f.get(), first);
+	dynamic_cast<FilterSimple::StatefulFilter<double>*>(f.get())->reset();
+	if ( run(f.get(), second) != expected ) {
+		cerr << filter << ": the output after reset() differs from a new filter" << endl;
+		ok = false;
+	}
+
+	// A gap resets the filter
+	f = create(filter);
+	f->setStartTime(Core::Time(StartTime));
+	run(f.get(), first);
+	f->setStartTime(Core::Time(secondTime + 10));
+	if ( run(f.get(), second) != expected ) {
+		cerr << filter << ": the output after a gap differs from a new filter" << endl;
+		ok = false;
+	}
+
+	// Continuous data keep the state
+	vector<double> all(first);
+	all.insert(all.end(), second.begin(), second.end());
+	auto uninterrupted = run(create(filter).get(), all);
+	uninterrupted.erase(uninterrupted.begin(), uninterrupted.begin() + first.size());
+
+	f = create(filter);
+	f->setStartTime(Core::Time(StartTime));
+	run(f.get(), first);
+	f->setStartTime(Core::Time(secondTime));
+	if ( run(f.get(), second) != uninterrupted ) {
+		cerr << filter << ": continuous data did not continue the state" << endl;
+		ok = false;
+	}
+
+	// Priming: a constant signal yields the steady state from the first
+	// sample on, also after a step at a gap. Zero initialised delay lines
+	// would ramp up over the filter length.
+	const double levels[] = { 2E6, -5E5 };
+	f = create(filter);
+	f->setStartTime(Core::Time(StartTime));
+	for ( auto level : levels ) {
+		vector<double> constant(RecordLength, level);
+		double deviation = transient(run(f.get(), constant), level);
+		if ( deviation > TransientLimit ) {
+			cerr << filter << ": start-up transient of " << deviation
+			     << " at level " << level << endl;
+			ok = false;
+		}
+		f->setStartTime(Core::Time(StartTime + 100));
+	}
+
+	return ok;
+}
+
+
+}
+
+
+/**
+ * Checks that the stateful filters of this plugin behave like a newly
+ * created filter after reset() or a gap, that continuous data keep the
+ * state and that the priming with the first sample removes the start-up
+ * transient.
+ */
+int main() {
+	bool ok = true;
+
+	for ( auto filter : Filters ) {
+		bool filterOk = check(filter);
+		cout << filter << (filterOk ? " ok" : " failed") << endl;
+		ok = ok && filterOk;
+	}
+
+	return ok ? 0 : 1;
+}
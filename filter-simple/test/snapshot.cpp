@@ -0,0 +1,186 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include <seiscomp/core/datetime.h>
+#include <seiscomp/math/filter.h>
+
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 100;
+constexpr int RecordLength = 512;
+constexpr int Records = 40;
+// The record after which the first process exits
+constexpr int Split = 17;
+const Core::Time StartTime(1700000000.0);
+
+const char *Filters[] = { "MEDIAN(1)", "MEDIAN(2,5000)", "RESAMPLE(40)" };
+
+
+using Filter = Math::Filtering::InPlaceFilter<double>;
+
+
+unique_ptr<Filter> create(const string &filter, const string &station, double startTime) {
+	unique_ptr<Filter> f(Filter::Create(filter));
+	if ( !f ) {
+		return nullptr;
+	}
+
+	f->setStreamID("XX", station, "", "HHZ");
+	f->setSamplingFrequency(SamplingFrequency);
+	f->setStartTime(Core::Time(startTime));
+	return f;
+}
+
+
+//! Filters the records [first, last) of the input with one filter
+void run(Filter *f, const vector<double> &input, int first, int last,
+         vector<double> &output) {
+	output.assign(input.begin() + first * RecordLength,
+	              input.begin() + last * RecordLength);
+	for ( size_t i = 0; i < output.size(); i += RecordLength ) {
+		f->apply(RecordLength, output.data() + i);
+	}
+}
+
+
+double splitTime() {
+	return double(StartTime) + Split * RecordLength / SamplingFrequency;
+}
+
+
+//! The first process: filters until the split and exits, the snapshot
+//! store writes the states of the destroyed filters.
+int firstProcess(const string &path, const vector<double> &input) {
+	FilterSimple::SnapshotStore::Instance().setPath(path);
+
+	for ( auto filter : Filters ) {
+		for ( auto station : { "CONT", "GAP" } ) {
+			auto f = create(filter, station, double(StartTime));
+			if ( !f ) {
+				return 1;
+			}
+
+			vector<double> output;
+			run(f.get(), input, 0, Split, output);
+		}
+	}
+
+	return 0;
+}
+
+
+}
+
+
+/**
+ * Checks that a filter restored from a snapshot continues exactly like a
+ * filter which has processed all data without a restart, and that a
+ * state is not restored if the data after the restart do not continue
+ * the data before it.
+ */
+int main() {
+	mt19937 rng(7);
+	normal_distribution<double> noise(0, 1E6);
+	vector<double> input(Records * RecordLength);
+	for ( auto &v : input ) {
+		v = noise(rng);
+	}
+
+	string path = "snapshot-" + to_string(getpid()) + ".bin";
+
+	cout.flush();
+	pid_t pid = fork();
+	if ( pid < 0 ) {
+		cerr << "fork failed" << endl;
+		return 1;
+	}
+
+	if ( pid == 0 ) {
+		// exit() destroys the snapshot store which saves the file
+		exit(firstProcess(path, input));
+	}
+
+	int status;
+	if ( waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+	  || WEXITSTATUS(status) != 0 ) {
+		cerr << "The first process failed" << endl;
+		unlink(path.c_str());
+		return 1;
+	}
+
+	FilterSimple::SnapshotStore::Instance().setPath(path);
+
+	bool ok = true;
+
+	for ( auto filter : Filters ) {
+		bool filterOk = true;
+
+		// The uninterrupted run, without a stream ID nothing is restored
+		// or stored
+		unique_ptr<Filter> f(Filter::Create(filter));
+		f->setSamplingFrequency(SamplingFrequency);
+		vector<double> reference, output;
+		run(f.get(), input, 0, Records, reference);
+		reference.erase(reference.begin(), reference.begin() + Split * RecordLength);
+
+		f = create(filter, "CONT", splitTime());
+		run(f.get(), input, Split, Records, output);
+		if ( output != reference ) {
+			cerr << filter << ": the restored filter deviates from the uninterrupted run" << endl;
+			filterOk = false;
+		}
+
+		// A gap of one second, the stored state must be ignored
+		vector<double> fresh;
+		f.reset(Filter::Create(filter));
+		f->setSamplingFrequency(SamplingFrequency);
+		run(f.get(), input, Split, Records, fresh);
+
+		f = create(filter, "GAP", splitTime() + 1);
+		run(f.get(), input, Split, Records, output);
+		if ( output != fresh ) {
+			cerr << filter << ": a state was restored after a gap" << endl;
+			filterOk = false;
+		}
+
+		cout << filter << (filterOk ? " ok" : " failed") << endl;
+		ok = ok && filterOk;
+	}
+
+	// The states of this process must not be written on exit
+	FilterSimple::SnapshotStore::Instance().setPath(string());
+	unlink(path.c_str());
+	return ok ? 0 : 1;
+}
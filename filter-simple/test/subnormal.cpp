@@ -0,0 +1,182 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/math/filter.h>
+
+#include "denormal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 100;
+constexpr int Samples = 100000;
+// Samples per apply() call as delivered by a typical SeedLink stream
+constexpr int RecordLength = 512;
+
+
+template <typename T>
+using FilterPtr = unique_ptr<Math::Filtering::InPlaceFilter<T>>;
+
+
+/**
+ * @brief Applies a filter record by record and checks that the output is
+ *        free of subnormal numbers and that the floating point mode of
+ *        the thread is unchanged after each call.
+ */
+template <typename T>
+bool check(const string &filter, const vector<double> &input) {
+	FilterPtr<T> f(Math::Filtering::InPlaceFilter<T>::Create(filter));
+	if ( !f ) {
+		cerr << "Could not create " << filter << endl;
+		return false;
+	}
+
+	f->setSamplingFrequency(SamplingFrequency);
+
+	vector<T> data(input.begin(), input.end());
+	int n = static_cast<int>(data.size());
+
+#if defined(FILTERSIMPLE_HAS_FTZ)
+	FilterSimple::FPState before = FilterSimple::fpState();
+#endif
+
+	for ( int i = 0; i < n; i += RecordLength ) {
+		f->apply(min(RecordLength, n - i), data.data() + i);
+
+#if defined(FILTERSIMPLE_HAS_FTZ)
+		if ( FilterSimple::fpState() != before ) {
+			cerr << filter << " changed the floating point mode of the thread" << endl;
+			return false;
+		}
+#endif
+	}
+
+	auto subnormal = count_if(data.begin(), data.end(), [](T v) {
+		return fpclassify(v) == FP_SUBNORMAL;
+	});
+
+	if ( subnormal ) {
+		cerr << filter << ": " << subnormal << " subnormal output samples" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief Checks that DITHER turns silence and subnormal input into
+ *        samples of the dither amplitude.
+ */
+template <typename T>
+bool checkDither() {
+	const T amplitude = static_cast<T>(1E-20);
+	vector<T> data(Samples, T(0));
+	for ( int i = 0; i < Samples; i += 2 ) {
+		data[i] = numeric_limits<T>::denorm_min();
+	}
+
+	FilterPtr<T> f(Math::Filtering::InPlaceFilter<T>::Create("DITHER"));
+	if ( !f ) {
+		cerr << "Could not create DITHER" << endl;
+		return false;
+	}
+
+	f->apply(Samples, data.data());
+
+	for ( T v : data ) {
+		if ( abs(v) != amplitude ) {
+			cerr << "DITHER produced " << v << " instead of +/-" << amplitude << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template <typename T>
+bool run() {
+	mt19937 rng(42);
+
+	// Loud noise followed by silence lets recursive states decay
+	normal_distribution<double> noise(0, 1E6);
+	vector<double> silence(Samples, 0.0);
+	for ( int i = 0; i < Samples / 2; ++i ) {
+		silence[i] = noise(rng);
+	}
+
+	// Noise just above the smallest normal number, sums of products of
+	// these samples fall into the subnormal range unless they are flushed
+	const double smallest = numeric_limits<T>::min();
+	uniform_real_distribution<double> tiny(-4 * smallest, 4 * smallest);
+	vector<double> faint(Samples);
+	for ( auto &v : faint ) {
+		v = tiny(rng);
+		if ( abs(v) < smallest ) {
+			v = copysign(smallest, v);
+		}
+	}
+
+	const string filters[] = {
+		"SIMPLE(1.5,100)", "SIMPLE(0.5,0)", "RESAMPLE(40)", "MEDIAN(1)",
+		"MEDIAN(1,5000)", "POLY(0,1,-2E-8)", "POLYLUT(-8E6,8E6,0,1,-2E-8)",
+		"LOGC(1E-3)", "DITHER"
+	};
+
+	bool ok = true;
+
+	for ( const auto &filter : filters ) {
+		ok = check<T>(filter, silence) && ok;
+	}
+
+	// Only RESAMPLE computes sums of products, the other filters pass
+	// samples of this range unchanged or scale them
+	ok = check<T>("RESAMPLE(40)", faint) && ok;
+	ok = check<T>("RESAMPLE(20)", faint) && ok;
+
+	return checkDither<T>() && ok;
+}
+
+
+}
+
+
+/**
+ * Checks deterministically that the filters of this plugin neither emit
+ * subnormal samples nor leave the floating point mode of the thread
+ * changed. The states of the filters are copies of input samples, hence
+ * they stay free of subnormal numbers as well. The slowdown itself is
+ * measured by bench_tmplfilter_denormal.
+ */
+int main() {
+	bool ok = run<double>();
+	ok = run<float>() && ok;
+	return ok ? 0 : 1;
+}
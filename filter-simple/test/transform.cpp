@@ -0,0 +1,204 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/math/filter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr double SamplingFrequency = 200;
+constexpr int Repetitions = 5;
+// Samples per apply() call as delivered by a typical SeedLink stream
+constexpr int RecordLength = 512;
+
+
+/**
+ * @brief Returns the minimum time in seconds of several runs of a
+ *        processing function on a copy of the data.
+ */
+template <typename T, typename Process>
+double measure(const vector<T> &input, Process process) {
+	double best = 1E300;
+	vector<T> data(input.size());
+
+	for ( int r = 0; r < Repetitions; ++r ) {
+		copy(input.begin(), input.end(), data.begin());
+		auto start = chrono::steady_clock::now();
+		process(data);
+		best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+	}
+
+	return best;
+}
+
+
+/**
+ * @brief Checks that POLYLUT passes values outside of its table, NaN
+ *        and infinity to the exact polynomial.
+ */
+template <typename T>
+bool checkNonFinite() {
+	const string filters[][2] = {
+		{ "POLYLUT(-8E6,8E6,0,1,-2E-8)", "POLY(0,1,-2E-8)" },
+		{ "POLYLUT(-8E6,8E6,10,1,1E-8,-1E-15)", "POLY(10,1,1E-8,-1E-15)" }
+	};
+
+	const T inf = numeric_limits<T>::infinity();
+	const vector<T> input = {
+		numeric_limits<T>::quiet_NaN(), inf, -inf, T(1E7), T(-1E7), T(-8.5E6)
+	};
+
+	bool ok = true;
+
+	for ( const auto &names : filters ) {
+		vector<T> table(input), exact(input);
+		unique_ptr<Math::Filtering::InPlaceFilter<T>> f(
+			Math::Filtering::InPlaceFilter<T>::Create(names[0])
+		);
+		unique_ptr<Math::Filtering::InPlaceFilter<T>> reference(
+			Math::Filtering::InPlaceFilter<T>::Create(names[1])
+		);
+		f->setSamplingFrequency(SamplingFrequency);
+		reference->setSamplingFrequency(SamplingFrequency);
+		f->apply(table);
+		reference->apply(exact);
+
+		for ( size_t i = 0; i < input.size(); ++i ) {
+			if ( isnan(table[i]) ? !isnan(exact[i]) : table[i] != exact[i] ) {
+				cerr << names[0] << "(" << input[i] << ") = " << table[i]
+				     << ", expected " << exact[i] << endl;
+				ok = false;
+			}
+		}
+	}
+
+	return ok;
+}
+
+
+template <typename T>
+bool run(const vector<string> &filters, const vector<double> &noise) {
+	vector<T> input(noise.begin(), noise.end());
+	int n = static_cast<int>(input.size());
+
+	// Reading and writing the data once is the lower bound of any
+	// transform
+	vector<T> target(input.size());
+	double copyTime = measure(input, [&target](vector<T> &data) {
+		copy(data.begin(), data.end(), target.begin());
+	});
+
+	cout << defaultfloat << setprecision(6) << left
+	     << setw(56) << "copy" << right << fixed << setprecision(1)
+	     << setw(8) << n / copyTime * 1E-6 << endl;
+
+	for ( const auto &filter : filters ) {
+		unique_ptr<Math::Filtering::InPlaceFilter<T>> f(
+			Math::Filtering::InPlaceFilter<T>::Create(filter)
+		);
+		if ( !f ) {
+			cerr << "Could not create " << filter << endl;
+			return false;
+		}
+
+		f->setSamplingFrequency(SamplingFrequency);
+
+		double elapsed = measure(input, [&f, n](vector<T> &data) {
+			for ( int i = 0; i < n; i += RecordLength ) {
+				f->apply(min(RecordLength, n - i), data.data() + i);
+			}
+		});
+
+		cout << defaultfloat << setprecision(6) << left
+		     << setw(56) << filter << right << fixed << setprecision(1)
+		     << setw(8) << n / elapsed * 1E-6
+		     << setw(9) << elapsed / copyTime << "x" << endl;
+	}
+
+	return true;
+}
+
+
+}
+
+
+/**
+ * Measures the throughput of POLY, POLYLUT and LOGC for polynomials of
+ * several degrees and compares it with copying the data. Fails if POLYLUT
+ * deviates from POLY for values outside of its table, NaN or infinity.
+ *
+ * Usage: bench_tmplfilter_transform [duration in s, default 3600]
+ */
+int main(int argc, char **argv) {
+	double duration = argc > 1 ? atof(argv[1]) : 3600;
+	if ( duration <= 0 ) {
+		cerr << "Invalid duration: " << argv[1] << endl;
+		return 1;
+	}
+
+	// The coefficients are normal single precision numbers and the
+	// results stay in the range of float for the input range
+	const vector<string> filters = {
+		"POLY(0,1,-2E-8)",
+		"POLY(0,1,-2E-8,1E-15,-1E-22)",
+		"POLY(0,1,-2E-8,1E-15,-1E-22,1E-29,-1E-36)",
+		"POLYLUT(-8E6,8E6,0,1,-2E-8)",
+		"POLYLUT(-8E6,8E6,0,1,-2E-8,1E-15,-1E-22,1E-29,-1E-36)",
+		"LOGC(1E-3)"
+	};
+
+	if ( !checkNonFinite<double>() || !checkNonFinite<float>() ) {
+		return 1;
+	}
+
+	mt19937 rng(42);
+	normal_distribution<double> distribution(0, 1E6);
+	vector<double> noise(static_cast<size_t>(duration * SamplingFrequency));
+	for ( auto &v : noise ) {
+		v = max(-8E6, min(8E6, distribution(rng)));
+	}
+
+	cout << left << setw(56) << "filter" << right << setw(8) << "[MS/s]"
+	     << setw(10) << "vs. copy" << endl;
+
+	cout << "double" << endl;
+	if ( !run<double>(filters, noise) ) {
+		return 1;
+	}
+
+	cout << "float" << endl;
+	if ( !run<float>(filters, noise) ) {
+		return 1;
+	}
+
+	return 0;
+}
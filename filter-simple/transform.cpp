@@ -0,0 +1,429 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#define SEISCOMP_COMPONENT FilterSimple
+
+#include <seiscomp/logging/log.h>
+#include <seiscomp/core/plugin.h>
+#include <seiscomp/math/filter.h>
+
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+using namespace FilterSimple;
+
+
+// Samples per Horner block, small enough to stay in L1
+constexpr int BlockSize = 256;
+// Maximum number of polynomial coefficients
+constexpr int MaxCoefficients = 32;
+// Number of intervals of the lookup table
+constexpr int TableIntervals = 4096;
+
+
+/**
+ * @brief Evaluates a polynomial for each sample with the Horner scheme.
+ * @param c The coefficients in ascending order
+ * @param order The order of the polynomial, c has order+1 elements
+ *
+ * Each step of the scheme is applied to a block of samples, every step is
+ * then a multiply-add over contiguous memory without a dependency chain
+ * between the samples.
+ */
+template <typename T>
+void applyHorner(const T *c, int order, int n, T *inout) {
+	T x[BlockSize];
+
+	for ( int offset = 0; offset < n; offset += BlockSize ) {
+		int count = min(BlockSize, n - offset);
+		T *y = inout + offset;
+
+		copy(y, y + count, x);
+
+		for ( int i = 0; i < count; ++i ) {
+			y[i] = c[order];
+		}
+
+		for ( int k = order - 1; k >= 0; --k ) {
+			const T ck = c[k];
+			for ( int i = 0; i < count; ++i ) {
+				y[i] = y[i] * x[i] + ck;
+			}
+		}
+	}
+}
+
+
+#if defined(__SSE2__)
+// The SSE2 variants keep a vector of samples in registers for all steps of
+// the scheme, the data are read and written once.
+template <>
+void applyHorner<float>(const float *c, int order, int n, float *inout) {
+	__m128 coeffs[MaxCoefficients];
+	for ( int k = 0; k <= order; ++k ) {
+		coeffs[k] = _mm_set1_ps(c[k]);
+	}
+
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 ) {
+		__m128 x = _mm_loadu_ps(inout + i);
+		__m128 y = coeffs[order];
+		for ( int k = order - 1; k >= 0; --k ) {
+			y = _mm_add_ps(_mm_mul_ps(y, x), coeffs[k]);
+		}
+		_mm_storeu_ps(inout + i, y);
+	}
+
+	for ( ; i < n; ++i ) {
+		float y = c[order];
+		for ( int k = order - 1; k >= 0; --k ) {
+			y = y * inout[i] + c[k];
+		}
+		inout[i] = y;
+	}
+}
+
+
+template <>
+void applyHorner<double>(const double *c, int order, int n, double *inout) {
+	__m128d coeffs[MaxCoefficients];
+	for ( int k = 0; k <= order; ++k ) {
+		coeffs[k] = _mm_set1_pd(c[k]);
+	}
+
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 ) {
+		// Two independent vectors hide the latency of the chain
+		__m128d x0 = _mm_loadu_pd(inout + i);
+		__m128d x1 = _mm_loadu_pd(inout + i + 2);
+		__m128d y0 = coeffs[order], y1 = coeffs[order];
+		for ( int k = order - 1; k >= 0; --k ) {
+			y0 = _mm_add_pd(_mm_mul_pd(y0, x0), coeffs[k]);
+			y1 = _mm_add_pd(_mm_mul_pd(y1, x1), coeffs[k]);
+		}
+		_mm_storeu_pd(inout + i, y0);
+		_mm_storeu_pd(inout + i + 2, y1);
+	}
+
+	for ( ; i < n; ++i ) {
+		double y = c[order];
+		for ( int k = order - 1; k >= 0; --k ) {
+			y = y * inout[i] + c[k];
+		}
+		inout[i] = y;
+	}
+}
+#endif
+
+
+/**
+ * @brief The PolynomialFilter class applies a polynomial sample by sample,
+ *        e.g. to correct a nonlinear sensor response.
+ *
+ * @code
+ * filter = "POLY(c0,c1,...,cn)"  # y = c0 + c1*x + ... + cn*x^n
+ * @endcode
+ *
+ * The polynomial is evaluated with the Horner scheme, with SSE2 on four
+ * samples at once, see applyHorner().
+ */
+template <typename T>
+class PolynomialFilter : public Math::Filtering::InPlaceFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		PolynomialFilter() = default;
+
+		PolynomialFilter(const vector<double> &coefficients)
+		: _coefficients(coefficients) {
+			init();
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void setSamplingFrequency(double fsamp) override {}
+
+		int setParameters(int n, const double *params) override {
+			if ( n < 1 ) {
+				return 1;
+			}
+
+			if ( n > MaxCoefficients ) {
+				return MaxCoefficients;
+			}
+
+			_coefficients.assign(params, params + n);
+			init();
+
+			return n;
+		}
+
+		void apply(int n, T *inout) override {
+			ThroughputScope scope(_counter, "POLY", { double(_typed.size()) }, n);
+			horner(n, inout);
+		}
+
+		Math::Filtering::InPlaceFilter<T>* clone() const override {
+			return new PolynomialFilter<T>(_coefficients);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Protected methods
+	// ------------------------------------------------------------------
+	protected:
+		void init() {
+			// Drop leading zero coefficients of higher orders
+			size_t degree = _coefficients.size();
+			while ( degree > 1 && _coefficients[degree-1] == 0 ) {
+				--degree;
+			}
+
+			_typed.assign(_coefficients.begin(), _coefficients.begin() + degree);
+		}
+
+		void horner(int n, T *inout) const {
+			if ( _typed.empty() ) {
+				return;
+			}
+
+			applyHorner(_typed.data(), static_cast<int>(_typed.size()) - 1, n, inout);
+		}
+
+		T evaluate(T x) const {
+			T y = _typed.back();
+			for ( int k = static_cast<int>(_typed.size()) - 2; k >= 0; --k ) {
+				y = y * x + _typed[k];
+			}
+			return y;
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Protected members
+	// ------------------------------------------------------------------
+	protected:
+		vector<double>    _coefficients;
+		vector<T>         _typed;
+		ThroughputCounter _counter;
+};
+
+
+/**
+ * @brief The PolynomialTableFilter class evaluates a polynomial through
+ *        a precomputed lookup table for a fixed input range.
+ *
+ * @code
+ * filter = "POLYLUT(xmin,xmax,c0,c1,...,cn)"
+ * @endcode
+ *
+ * The table has 4096 intervals and is interpolated linearly. Samples
+ * outside of [xmin,xmax] are evaluated exactly. The lookup is scalar
+ * and independent of the degree, with SSE2 it is only faster than POLY
+ * for degrees above 6. The error is bounded by the curvature of the
+ * polynomial within an interval.
+ */
+template <typename T>
+class PolynomialTableFilter : public PolynomialFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		PolynomialTableFilter() = default;
+
+		PolynomialTableFilter(double xmin, double xmax, const vector<double> &coefficients)
+		: PolynomialFilter<T>(coefficients), _xmin(xmin), _xmax(xmax) {
+			buildTable();
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		int setParameters(int n, const double *params) override {
+			if ( n < 3 ) {
+				return 3;
+			}
+
+			if ( params[1] <= params[0] ) {
+				return -2;
+			}
+
+			int r = PolynomialFilter<T>::setParameters(n - 2, params + 2);
+			if ( r < 0 ) {
+				return r - 2;
+			}
+
+			if ( r != n - 2 ) {
+				return r + 2;
+			}
+
+			_xmin = params[0];
+			_xmax = params[1];
+			buildTable();
+
+			return n;
+		}
+
+		void apply(int n, T *inout) override {
+			ThroughputScope scope(this->_counter, "POLYLUT", { _xmin, _xmax }, n);
+
+			const T xmin = static_cast<T>(_xmin);
+			const T xmax = static_cast<T>(_xmax);
+			const T *table = _table.data();
+
+			for ( int i = 0; i < n; ++i ) {
+				T x = inout[i];
+				// Also catches NaN which must not be converted to an index
+				if ( !(x >= xmin && x <= xmax) ) {
+					inout[i] = this->evaluate(x);
+					continue;
+				}
+
+				T f = (x - xmin) * _scale;
+				int idx = min(static_cast<int>(f), TableIntervals - 1);
+				T frac = f - idx;
+				inout[i] = table[idx] + frac * (table[idx+1] - table[idx]);
+			}
+		}
+
+		Math::Filtering::InPlaceFilter<T>* clone() const override {
+			return new PolynomialTableFilter<T>(_xmin, _xmax, this->_coefficients);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private methods
+	// ------------------------------------------------------------------
+	private:
+		void buildTable() {
+			_table.resize(TableIntervals + 1);
+			double step = (_xmax - _xmin) / TableIntervals;
+
+			// Evaluate in double precision, the table is used for float
+			// data as well.
+			for ( int i = 0; i <= TableIntervals; ++i ) {
+				double x = _xmin + i * step, y = 0;
+				for ( auto it = this->_coefficients.rbegin(); it != this->_coefficients.rend(); ++it ) {
+					y = y * x + *it;
+				}
+				_table[i] = static_cast<T>(y);
+			}
+
+			_scale = static_cast<T>(TableIntervals / (_xmax - _xmin));
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		double    _xmin{0};
+		double    _xmax{1};
+		T         _scale{0};
+		vector<T> _table;
+};
+
+
+/**
+ * @brief The LogCompressionFilter class compresses the dynamic range of
+ *        characteristic functions.
+ *
+ * @code
+ * filter = "LOGC(a)"  # y = sign(x) * log(1 + a*|x|)
+ * @endcode
+ */
+template <typename T>
+class LogCompressionFilter : public Math::Filtering::InPlaceFilter<T> {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		LogCompressionFilter(double a = 1.0) : _a(a) {}
+
+
+	// ------------------------------------------------------------------
+	//  Public InplaceFilter interface
+	// ------------------------------------------------------------------
+	public:
+		void setSamplingFrequency(double fsamp) override {}
+
+		int setParameters(int n, const double *params) override {
+			if ( n != 1 ) {
+				return 1;
+			}
+
+			if ( params[0] <= 0 ) {
+				return -1;
+			}
+
+			_a = params[0];
+			return 1;
+		}
+
+		void apply(int n, T *inout) override {
+			ThroughputScope scope(_counter, "LOGC", { _a }, n);
+
+			const T a = static_cast<T>(_a);
+			for ( int i = 0; i < n; ++i ) {
+				T y = log1p(a * abs(inout[i]));
+				inout[i] = inout[i] < 0 ? -y : y;
+			}
+		}
+
+		Math::Filtering::InPlaceFilter<T>* clone() const override {
+			return new LogCompressionFilter<T>(_a);
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		double            _a;
+		ThroughputCounter _counter;
+};
+
+
+INSTANTIATE_INPLACE_FILTER(PolynomialFilter, SC_SYSTEM_CORE_API);
+INSTANTIATE_INPLACE_FILTER(PolynomialTableFilter, SC_SYSTEM_CORE_API);
+INSTANTIATE_INPLACE_FILTER(LogCompressionFilter, SC_SYSTEM_CORE_API);
+REGISTER_INPLACE_FILTER(PolynomialFilter, "POLY");
+REGISTER_INPLACE_FILTER(PolynomialTableFilter, "POLYLUT");
+REGISTER_INPLACE_FILTER(LogCompressionFilter, "LOGC");
+
+
+}
@@ -13,8 +13,11 @@
 ############################################################################
 
 
+import errno
+import selectors
 import socket
 import sys
+import time
 
 from seiscomp import client, core, datamodel, logging, system
 
@@ -24,11 +27,124 @@ class StreamItem:
     port = None
     configured = False
     portStatus = None
+    # The last reported ping and when it was reported
+    ping = None
+    reported = None
 
-    def __init__(self, configured=False):
+    def __init__(self, waveformID=None, configured=False):
+        # The parsed stream ID, shared by all QC objects of the stream
+        self.waveformID = waveformID
         self.configured = configured
 
 
+class ProbeResult:
+    def __init__(self, ping, start, end):
+        self.ping = ping
+        self.start = start
+        self.end = end
+
+
+class PortProber:
+    """
+    Checks the accessibility of many TCP ports concurrently with
+    non-blocking connects. At most `concurrency` connections are pending at
+    a time and each connection attempt is given up after `timeout` seconds.
+    Host names are resolved blocking before their connect.
+    """
+
+    def __init__(self, concurrency=64, timeout=10.0):
+        self.concurrency = max(1, concurrency)
+        self.timeout = timeout
+
+    def probe(self, addresses):
+        """
+        Probes (host, port) tuples and returns a dictionary of ProbeResult
+        objects by address. The ping is the connect time in milliseconds or
+        -1 if the port is not accessible.
+        """
+        results = {}
+        queue = list(addresses)
+        queue.reverse()
+        pending = {}
+
+        with selectors.DefaultSelector() as selector:
+            while queue or pending:
+                while queue and len(pending) < self.concurrency:
+                    address = queue.pop()
+                    sock = self._connect(address, results)
+                    if sock:
+                        pending[sock] = (address, core.Time.UTC(), time.monotonic())
+                        selector.register(sock, selectors.EVENT_WRITE)
+
+                if not pending:
+                    continue
+
+                now = time.monotonic()
+                deadline = min(started for _, _, started in pending.values())
+                events = selector.select(max(0.0, deadline + self.timeout - now))
+
+                for key, _ in events:
+                    sock = key.fileobj
+                    address, start, started = pending.pop(sock)
+                    selector.unregister(sock)
+                    error = sock.getsockopt(socket.SOL_SOCKET, socket.SO_ERROR)
+                    sock.close()
+
+                    if error == 0:
+                        ping = int((time.monotonic() - started) * 1000)
+                        logging.debug(f"{address[0]}:{address[1]} is accessible")
+                    else:
+                        ping = -1
+                        logging.debug(
+                            f"{address[0]}:{address[1]} is not accessible: "
+                            f"{errno.errorcode.get(error, error)}"
+                        )
+
+                    results[address] = ProbeResult(ping, start, core.Time.UTC())
+
+                # Give up connections which exceeded the timeout
+                now = time.monotonic()
+                for sock, (address, start, started) in list(pending.items()):
+                    if now - started < self.timeout:
+                        continue
+
+                    del pending[sock]
+                    selector.unregister(sock)
+                    sock.close()
+                    logging.debug(
+                        f"{address[0]}:{address[1]} is not accessible, got timeout"
+                    )
+                    results[address] = ProbeResult(-1, start, core.Time.UTC())
+
+        return results
+
+    @staticmethod
+    def _connect(address, results):
+        start = core.Time.UTC()
+        host, port = address
+        try:
+            # Name resolution blocks, but the few distinct hosts of a sweep
+            # are usually cached by the resolver
+            family, kind, proto, _, sockaddr = socket.getaddrinfo(
+                host, int(port), type=socket.SOCK_STREAM
+            )[0]
+            sock = socket.socket(family, kind, proto)
+        except (OSError, ValueError) as err:
+            logging.debug(f"socket error for {host}:{port}: {err}")
+            results[address] = ProbeResult(-1, start, core.Time.UTC())
+            return None
+
+        sock.setblocking(False)
+        result = sock.connect_ex(sockaddr)
+        if result not in (0, errno.EINPROGRESS, errno.EWOULDBLOCK):
+            sock.close()
+            logging.debug(f"{host}:{port} is not accessible")
+            results[address] = ProbeResult(-1, start, core.Time.UTC())
+            return None
+
+        return sock
+
+
 class App(client.Application):
 
     def __init__(self, argc, argv):
@@ -39,8 +155,23 @@ class App(client.Application):
         self.setLoadConfigModuleEnabled(True)
         self.setPrimaryMessagingGroup("QC")
         self.waveformIDs = {}
+        # Stream IDs by network and station code
+        self.stationStreams = {}
         self.inputFile = None
         self.timerInterval = 60
+        self.concurrency = 64
+        self.timeout = 10.0
+        # Four timer intervals unless configured
+        self.maxBackoff = None
+        self.batchSize = 500
+        self.changesOnly = False
+        self.pingThreshold = 100
+        self.keepAlive = 3600
+        self.lastSummary = None
+        # Failure count and next probe time of inaccessible addresses
+        self.deadAddresses = {}
+        # Monotonic time of the next regular sweep
+        self.nextSweep = None
 
     def createCommandLineDescription(self):
         self.commandline().addGroup("Input")
@@ -54,6 +185,55 @@ class App(client.Application):
             "Input", "timer", "Timer interval in seconds (default: 60)"
         )
 
+        self.commandline().addGroup("Probing")
+        self.commandline().addStringOption(
+            "Probing",
+            "concurrency",
+            "Maximum number of simultaneous connection attempts (default: 64)",
+        )
+        self.commandline().addStringOption(
+            "Probing",
+            "timeout",
+            "Connection timeout per address in seconds, host names are resolved "
+            "blocking before the timeout starts (default: 10)",
+        )
+        self.commandline().addStringOption(
+            "Probing",
+            "max-backoff",
+            "Maximum interval in seconds at which inaccessible addresses are "
+            "probed again, the interval starts at twice the timer interval and "
+            "doubles with each failure. Backed off streams are reported as not "
+            "accessible in each cycle. 0 probes every cycle (default: 4 times "
+            "the timer interval)",
+        )
+
+        self.commandline().addGroup("Output")
+        self.commandline().addStringOption(
+            "Output",
+            "batch-size",
+            "Maximum number of QC objects sent in one message, 0 sends all "
+            "objects of a sweep in one message (default: 500)",
+        )
+        self.commandline().addOption(
+            "Output",
+            "changes-only",
+            "Only send QC objects of a stream if its port status changed, its "
+            "ping changed by more than the ping threshold or the keep-alive "
+            "interval has passed",
+        )
+        self.commandline().addStringOption(
+            "Output",
+            "ping-threshold",
+            "Ping change in milliseconds which is reported in changes-only mode "
+            "(default: 100)",
+        )
+        self.commandline().addStringOption(
+            "Output",
+            "keep-alive",
+            "Interval in seconds at which unchanged streams are reported and a "
+            "summary is logged in changes-only mode (default: 3600)",
+        )
+
         return True
 
     def validateParameters(self) -> bool:
@@ -82,6 +262,66 @@ class App(client.Application):
                     f"Timer interval not configured, set to {self.timerInterval}"
                 )
 
+        try:
+            self.concurrency = int(self.commandline().optionString("concurrency"))
+        except RuntimeError:
+            try:
+                self.concurrency = self.configGetInt("concurrency")
+            except RuntimeError:
+                pass
+
+        try:
+            self.timeout = float(self.commandline().optionString("timeout"))
+        except RuntimeError:
+            try:
+                self.timeout = self.configGetDouble("timeout")
+            except RuntimeError:
+                pass
+
+        try:
+            self.maxBackoff = int(self.commandline().optionString("max-backoff"))
+        except RuntimeError:
+            try:
+                self.maxBackoff = self.configGetInt("maxBackoff")
+            except RuntimeError:
+                self.maxBackoff = 4 * self.timerInterval
+
+        try:
+            self.batchSize = int(self.commandline().optionString("batch-size"))
+        except RuntimeError:
+            try:
+                self.batchSize = self.configGetInt("batchSize")
+            except RuntimeError:
+                pass
+
+        if self.commandline().hasOption("changes-only"):
+            self.changesOnly = True
+        else:
+            try:
+                self.changesOnly = self.configGetBool("changesOnly")
+            except RuntimeError:
+                pass
+
+        try:
+            self.pingThreshold = int(self.commandline().optionString("ping-threshold"))
+        except RuntimeError:
+            try:
+                self.pingThreshold = self.configGetInt("pingThreshold")
+            except RuntimeError:
+                pass
+
+        try:
+            self.keepAlive = int(self.commandline().optionString("keep-alive"))
+        except RuntimeError:
+            try:
+                self.keepAlive = self.configGetInt("keepAlive")
+            except RuntimeError:
+                pass
+
+        if self.concurrency < 1 or self.timeout <= 0:
+            logging.error("concurrency and timeout must be positive")
+            return False
+
         return True
 
     def init(self):
@@ -128,7 +368,14 @@ class App(client.Application):
                         cha = loc.stream(istr)
                         wfID = f"{net.code()}.{sta.code()}.{loc.code()}.{cha.code()}"
                         logging.debug(f"Found stream:  {wfID}")
-                        self.waveformIDs[wfID] = StreamItem()
+                        self.waveformIDs[wfID] = StreamItem(
+                            datamodel.WaveformStreamID(
+                                net.code(), sta.code(), loc.code(), cha.code(), ""
+                            )
+                        )
+                        self.stationStreams.setdefault(net.code(), {}).setdefault(
+                            sta.code(), []
+                        ).append(wfID)
 
         logging.info(f"Read {len(self.waveformIDs)} streams from inventory")
 
@@ -211,14 +458,11 @@ class App(client.Application):
                 continue
 
             logging.info(f"  {network}.{station}.{ip}.{port}")
-            wfFilter = f"{network}."
-            if station != "*":
-                wfFilter += f"{station}."
-            res = [
-                key
-                for key, _value in self.waveformIDs.items()
-                if key.startswith(wfFilter)
-            ]
+            stations = self.stationStreams.get(network, {})
+            if station == "*":
+                res = [key for keys in stations.values() for key in keys]
+            else:
+                res = stations.get(station, [])
 
             if not res:
                 logging.error(
@@ -237,123 +481,178 @@ class App(client.Application):
 
         return True
 
-    @staticmethod
-    def checkAccessiblePort(ip, port):
-        testSocket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        testSocket.settimeout(10)
-        source = (ip, int(port))
-        try:
-            start = core.Time.UTC()
-            result = testSocket.connect_ex(source)
-            testSocket.close()
-            end = core.Time.UTC()
-            ping = int(float(end - start) * 1000)
-        except socket.timeout:
-            logging.debug(f"{ip}:{port} is not accessible, got timeout")
-            return -1
-        except socket.gaierror as err:
-            logging.debug(f"socket error for {ip}:{port}: {err}")
-            return -1
-
-        if result == 0:
-            logging.debug(f"{ip}:{port} is accessible")
-            return ping
-
-        logging.debug(f"{ip}:{port} is not accessible")
-        return -1
-
     def processStation(self):
         logging.debug(f"Start processing of {len(self.waveformIDs)}")
-        results = {}
-        for waveformID, item in self.waveformIDs.items():
-            if not item.ip:
-                continue
 
-            address = f"{item.ip}:{item.port}"
-            if address in results:
-                ping = results[address]["ping"]
-                portStatus = results[address]["portstatus"]
-                end = start = results[address]["end"]
+        # Probe each address once, all addresses at the same time
+        now = time.monotonic()
+        start = core.Time.UTC()
+        addresses = {
+            (item.ip, item.port) for item in self.waveformIDs.values() if item.ip
+        }
+        due = {address for address in addresses if self.isDue(address, now)}
+        prober = PortProber(self.concurrency, self.timeout)
+        results = prober.probe(sorted(due))
 
+        for address, result in results.items():
+            self.updateBackoff(address, result.ping >= 0, now)
+
+        # Backed off addresses keep their last result, not accessible
+        end = core.Time.UTC()
+        for address in addresses - due:
+            results[address] = ProbeResult(-1, start, end)
+
+        wqs = []
+        for item in self.waveformIDs.values():
+            result = results.get((item.ip, item.port))
+            if not result:
+                continue
+
+            if result.ping >= 0:
+                portStatus = int(item.port)
             else:
-                start = core.Time.UTC()
-                ping = self.checkAccessiblePort(item.ip, item.port)
-                end = core.Time.UTC()
-                results[address] = {}
-                results[address]["ping"] = ping
-                if ping >= 0:
-                    portStatus = int(item.port)
-                else:
-                    portStatus = -1 * int(item.port)
-
-                results[address]["portstatus"] = portStatus
-                results[address]["start"] = start
-                results[address]["end"] = end
-
-            wqs = self.generateQCObject(waveformID, ping, portStatus, start, end)
-            for wq in wqs:
-                self.sendWaveformQuality(wq, waveformID)
+                portStatus = -1 * int(item.port)
+
+            if self.changesOnly and not self.hasChanged(
+                item, result.ping, portStatus, now
+            ):
+                continue
+
+            item.portStatus = portStatus
+            item.ping = result.ping
+            item.reported = now
+
+            wqs.extend(
+                self.generateQCObject(
+                    item.waveformID, result.ping, portStatus, result.start, result.end
+                )
+            )
+
+        self.sendWaveformQualities(wqs)
+
+        if self.changesOnly:
+            self.logSummary(len(wqs) // 2, now)
 
         return True
 
+    def hasChanged(self, item, ping, portStatus, now):
+        if item.reported is None or now - item.reported >= self.keepAlive:
+            return True
+
+        if portStatus != item.portStatus:
+            return True
+
+        return abs(ping - item.ping) > self.pingThreshold
+
+    def logSummary(self, reported, now):
+        if self.lastSummary is not None and now - self.lastSummary < self.keepAlive:
+            return
+
+        self.lastSummary = now
+        streams = [item for item in self.waveformIDs.values() if item.ip]
+        accessible = sum(
+            1 for item in streams if item.portStatus and item.portStatus > 0
+        )
+        inaccessible = sum(
+            1 for item in streams if item.portStatus and item.portStatus < 0
+        )
+        logging.info(
+            f"Summary: {len(streams)} streams, {accessible} accessible, "
+            f"{inaccessible} not accessible, {reported} reported in last sweep"
+        )
+
+    def isDue(self, address, now):
+        state = self.deadAddresses.get(address)
+        # Sweeps start with a jitter, an address due within half a cycle is
+        # probed in this one
+        return state is None or now >= state[1] - self.timerInterval / 2
+
+    def updateBackoff(self, address, accessible, now):
+        if accessible or self.maxBackoff <= 0:
+            if self.deadAddresses.pop(address, None):
+                logging.info(f"{address[0]}:{address[1]} is accessible again")
+            return
+
+        failures = self.deadAddresses.get(address, (0, 0))[0] + 1
+        # The first delay skips at least one cycle
+        delay = min(self.timerInterval * 2**failures, self.maxBackoff)
+        self.deadAddresses[address] = (failures, now + delay)
+        if failures > 1:
+            logging.debug(
+                f"{address[0]}:{address[1]} failed {failures} times, next probe "
+                f"in {delay:.0f} s"
+            )
+
     @staticmethod
     def generateQCObject(waveformID, ping, portStatus, start, end):
-        wqs = []
-
-        wq = datamodel.WaveformQuality()
-        network, station, location, channel = waveformID.split(".")
-        wID = datamodel.WaveformStreamID()
-        wID.setNetworkCode(network)
-        wID.setStationCode(station)
-        wID.setLocationCode(location)
-        wID.setChannelCode(channel)
-        wq.setWaveformID(wID)
-        wq.setCreatorID("qcmsg")
-        wq.setCreated(core.Time.UTC())
-        wq.setStart(start)
-        wq.setEnd(end)
-        wq.setType("report")
-        wq.setParameter("ping")
-        wq.setValue(ping)
+        created = core.Time.UTC()
+        windowLength = float(end - start)
+
+        def create(parameter, value):
+            wq = datamodel.WaveformQuality()
+            wq.setWaveformID(waveformID)
+            wq.setCreatorID("qcmsg")
+            wq.setCreated(created)
+            wq.setStart(start)
+            wq.setEnd(end)
+            wq.setType("report")
+            wq.setParameter(parameter)
+            wq.setValue(value)
+            wq.setWindowLength(windowLength)
+            return wq
+
+        wq = create("ping", ping)
         wq.setLowerUncertainty(0.0)
         wq.setUpperUncertainty(0.0)
-        wq.setWindowLength(float(end - start))
-        wqs.append(wq)
-
-        wq = datamodel.WaveformQuality()
-        network, station, location, channel = waveformID.split(".")
-        wID = datamodel.WaveformStreamID()
-        wID.setNetworkCode(network)
-        wID.setStationCode(station)
-        wID.setLocationCode(location)
-        wID.setChannelCode(channel)
-        wq.setWaveformID(wID)
-        wq.setCreatorID("qcmsg")
-        wq.setCreated(core.Time.UTC())
-        wq.setStart(start)
-        wq.setEnd(end)
-        wq.setType("report")
-        wq.setParameter("portstatus")
-        wq.setValue(portStatus)
-        wq.setWindowLength(float(end - start))
-        wqs.append(wq)
-
-        return wqs
-
-    def sendWaveformQuality(self, wq, waveformID):
-        dataMsg = core.DataMessage()
-        dataMsg.attach(wq)
-        logging.debug(
-            f"Sending QC message for {waveformID} with '{wq.parameter()}={wq.value()}'"
-        )
-        self.connection().send(dataMsg)
+
+        return [wq, create("portstatus", portStatus)]
+
+    def sendWaveformQualities(self, wqs):
+        size = self.batchSize if self.batchSize > 0 else max(len(wqs), 1)
+        for i in range(0, len(wqs), size):
+            dataMsg = core.DataMessage()
+            for wq in wqs[i : i + size]:
+                dataMsg.attach(wq)
+            logging.debug(f"Sending QC message with {dataMsg.size()} objects")
+            if not self.connection().send(dataMsg):
+                logging.error("Failed to send QC message")
+                return False
+
         return True
 
     def handleTimeout(self):
-        self.processStation()
+        now = time.monotonic()
+
+        # Timer events which queued up during a long sweep arrive right after
+        # it, they are dropped until the next cycle of the timer is due
+        if (
+            self.nextSweep is not None
+            and now < self.nextSweep - self.timerInterval / 4
+        ):
+            logging.debug("Skipping overdue cycle")
+            return True
+
+        try:
+            self.processStation()
+        finally:
+            duration = time.monotonic() - now
+            # The sweep started with a timer event, the next event of the
+            # timer after the end of the sweep starts the next one
+            cycles = int(duration // self.timerInterval) + 1
+            self.nextSweep = now + cycles * self.timerInterval
+
+        if duration > self.timerInterval:
+            logging.warning(
+                f"Sweep took {duration:.1f} s which exceeds the timer interval "
+                f"of {self.timerInterval} s, overdue cycles are skipped"
+            )
+        else:
+            logging.debug(f"Sweep took {duration:.1f} s")
+
         return True
 
 
-app = App(len(sys.argv), sys.argv)
-app.setMessagingUsername("qcping")
-sys.exit(app())
+if __name__ == "__main__":
+    app = App(len(sys.argv), sys.argv)
+    app.setMessagingUsername("qcping")
+    sys.exit(app())
@@ -0,0 +1,172 @@
+#!/usr/bin/env seiscomp-python
+# -*- coding: utf-8 -*-
+############################################################################
+# Copyright (C) gempa GmbH                                                 #
+#                                                                          #
+# GNU Affero General Public License Usage                                  #
+# This file may be used under the terms of the GNU Affero                  #
+# Public License version 3.0 as published by the Free Software Foundation  #
+# and appearing in the file LICENSE included in the packaging of this      #
+# file. Please review the following information to ensure the GNU Affero   #
+# Public License version 3.0 requirements will be met:                     #
+# https://www.gnu.org/licenses/agpl-3.0.html.                              #
+############################################################################
+
+
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import qcping  # pylint: disable=C0413
+
+
+class Clock:
+    def __init__(self):
+        self.now = 0.0
+
+    def monotonic(self):
+        return self.now
+
+
+class FakeProber:
+    """Returns the pings of FakeProber.pings instead of connecting"""
+
+    pings = {}
+    probed = []
+
+    def __init__(self, concurrency, timeout):
+        pass
+
+    def probe(self, addresses):
+        FakeProber.probed.append(list(addresses))
+        start = qcping.core.Time.UTC()
+        return {
+            address: qcping.ProbeResult(FakeProber.pings[address], start, start)
+            for address in addresses
+        }
+
+
+class TestChangesOnly(unittest.TestCase):
+    """
+    Runs sweeps with simulated probe results and checks which streams are
+    sent: changes-only mode suppresses unchanged streams and sends them
+    again after the keep-alive interval.
+    """
+
+    def setUp(self):
+        self.clock = Clock()
+        self.patched = (qcping.time, qcping.PortProber)
+        qcping.time = self.clock
+        qcping.PortProber = FakeProber
+        FakeProber.probed = []
+
+        self.app = qcping.App(1, ["qcping"])
+        self.app.changesOnly = True
+        self.app.pingThreshold = 100
+        self.app.keepAlive = 3600
+        self.app.maxBackoff = 0
+
+        FakeProber.pings = {}
+        for i, station in enumerate(("A", "B", "C")):
+            item = qcping.StreamItem(f"XX.{station}..HHZ", True)
+            item.ip = f"host{i}"
+            item.port = "18000"
+            self.app.waveformIDs[item.waveformID] = item
+            FakeProber.pings[(item.ip, item.port)] = 20
+
+        self.sent = []
+        self.app.generateQCObject = (
+            lambda waveformID, ping, portStatus, start, end: [
+                (waveformID, "ping", ping),
+                (waveformID, "portstatus", portStatus),
+            ]
+        )
+        self.app.sendWaveformQualities = self.sent.append
+
+    def tearDown(self):
+        qcping.time, qcping.PortProber = self.patched
+
+    def sweep(self, now):
+        self.clock.now = now
+        del self.sent[:]
+        self.app.processStation()
+        self.assertEqual(len(self.sent), 1)
+        return {
+            (waveformID, parameter): value
+            for waveformID, parameter, value in self.sent[0]
+        }
+
+    def testSuppressUnchanged(self):
+        sent = self.sweep(0)
+        self.assertEqual(len(sent), 6)
+        self.assertEqual(sent[("XX.A..HHZ", "ping")], 20)
+        self.assertEqual(sent[("XX.A..HHZ", "portstatus")], 18000)
+
+        # Nothing changed
+        self.assertEqual(self.sweep(60), {})
+
+        # Changes within the ping threshold are not sent
+        FakeProber.pings[("host0", "18000")] = 120
+        self.assertEqual(self.sweep(120), {})
+
+        # Larger changes and a changed port status are sent
+        FakeProber.pings[("host0", "18000")] = 121
+        FakeProber.pings[("host1", "18000")] = -1
+        sent = self.sweep(180)
+        self.assertEqual(
+            sent,
+            {
+                ("XX.A..HHZ", "ping"): 121,
+                ("XX.A..HHZ", "portstatus"): 18000,
+                ("XX.B..HHZ", "ping"): -1,
+                ("XX.B..HHZ", "portstatus"): -18000,
+            },
+        )
+
+        # The threshold applies to the last sent ping, not the last probed
+        FakeProber.pings[("host0", "18000")] = 30
+        self.assertEqual(self.sweep(240), {})
+        FakeProber.pings[("host0", "18000")] = 20
+        self.assertEqual(
+            set(self.sweep(300)), {("XX.A..HHZ", "ping"), ("XX.A..HHZ", "portstatus")}
+        )
+
+    def testKeepAlive(self):
+        self.assertEqual(len(self.sweep(0)), 6)
+        FakeProber.pings[("host1", "18000")] = 500
+        self.assertEqual(len(self.sweep(60)), 2)
+
+        # Unchanged streams are sent again one keep-alive interval after
+        # they were sent last
+        self.assertEqual(self.sweep(3599), {})
+        sent = self.sweep(3600)
+        self.assertEqual({key[0] for key in sent}, {"XX.A..HHZ", "XX.C..HHZ"})
+        self.assertEqual(sent[("XX.A..HHZ", "ping")], 20)
+
+        sent = self.sweep(3660)
+        self.assertEqual({key[0] for key in sent}, {"XX.B..HHZ"})
+        self.assertEqual(sent[("XX.B..HHZ", "ping")], 500)
+
+        self.assertEqual(self.sweep(3720), {})
+
+    def testAllWithoutChangesOnly(self):
+        self.app.changesOnly = False
+        for now in (0, 60, 120):
+            self.assertEqual(len(self.sweep(now)), 6)
+
+    def testBackedOffStreams(self):
+        # With a backoff the streams of a dead host are reported as not
+        # accessible without probing, unchanged they are not sent again
+        self.app.maxBackoff = 240
+        FakeProber.pings[("host2", "18000")] = -1
+        self.assertEqual(len(self.sweep(0)), 6)
+        self.assertEqual(self.sweep(60), {})
+        self.assertNotIn(("host2", "18000"), FakeProber.probed[-1])
+        sent = self.sweep(3600)
+        self.assertEqual(sent[("XX.C..HHZ", "portstatus")], -18000)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,171 @@
+#!/usr/bin/env seiscomp-python
+# -*- coding: utf-8 -*-
+############################################################################
+# Copyright (C) gempa GmbH                                                 #
+#                                                                          #
+# GNU Affero General Public License Usage                                  #
+# This file may be used under the terms of the GNU Affero                  #
+# Public License version 3.0 as published by the Free Software Foundation  #
+# and appearing in the file LICENSE included in the packaging of this      #
+# file. Please review the following information to ensure the GNU Affero   #
+# Public License version 3.0 requirements will be met:                     #
+# https://www.gnu.org/licenses/agpl-3.0.html.                              #
+############################################################################
+
+
+import os
+import socket
+import sys
+import time
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from qcping import PortProber  # pylint: disable=C0413
+
+
+HOST = "127.0.0.1"
+
+
+def listen(backlog=16):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.bind((HOST, 0))
+    sock.listen(backlog)
+    return sock
+
+
+def closedPort():
+    # A port which was just released is not reused immediately
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.bind((HOST, 0))
+    port = sock.getsockname()[1]
+    sock.close()
+    return port
+
+
+class Unresponsive:
+    """
+    A listening socket whose accept queue is full and which is never
+    accepted. Further connection attempts are not answered and time out.
+    """
+
+    def __init__(self):
+        self.server = listen(0)
+        self.port = self.server.getsockname()[1]
+        self.client = socket.create_connection((HOST, self.port), timeout=5)
+
+    def close(self):
+        self.client.close()
+        self.server.close()
+
+
+class CountingProber(PortProber):
+    """Records the largest number of pending connection attempts"""
+
+    def __init__(self, concurrency, timeout):
+        super().__init__(concurrency, timeout)
+        self.sockets = []
+        self.maxPending = 0
+
+    def _connect(self, address, results):
+        sock = PortProber._connect(address, results)
+        if sock:
+            self.sockets.append(sock)
+            pending = sum(1 for s in self.sockets if s.fileno() >= 0)
+            self.maxPending = max(self.maxPending, pending)
+        return sock
+
+
+class TestPortProber(unittest.TestCase):
+    def setUp(self):
+        self.unresponsive = []
+
+    def tearDown(self):
+        for item in self.unresponsive:
+            item.close()
+
+    def createUnresponsive(self, count):
+        for _ in range(count):
+            self.unresponsive.append(Unresponsive())
+        return [(HOST, item.port) for item in self.unresponsive[-count:]]
+
+    def testOpen(self):
+        with listen() as server:
+            address = (HOST, server.getsockname()[1])
+            results = PortProber(4, 5).probe([address])
+
+        self.assertEqual(list(results), [address])
+        self.assertGreaterEqual(results[address].ping, 0)
+        self.assertLess(results[address].ping, 1000)
+        self.assertLessEqual(results[address].start, results[address].end)
+
+    def testRefused(self):
+        address = (HOST, closedPort())
+        started = time.monotonic()
+        results = PortProber(4, 5).probe([address])
+
+        self.assertEqual(results[address].ping, -1)
+        # Refused right away, not after the timeout
+        self.assertLess(time.monotonic() - started, 2)
+
+    def testTimeout(self):
+        address = self.createUnresponsive(1)[0]
+        started = time.monotonic()
+        results = PortProber(4, 0.5).probe([address])
+        duration = time.monotonic() - started
+
+        self.assertEqual(results[address].ping, -1)
+        self.assertGreaterEqual(duration, 0.5)
+        self.assertLess(duration, 2)
+
+    def testInvalidAddress(self):
+        addresses = [(HOST, "port"), (HOST, "70000"), ("host.invalid", "18000")]
+        results = PortProber(4, 5).probe(addresses)
+
+        self.assertEqual(set(results), set(addresses))
+        self.assertTrue(all(result.ping == -1 for result in results.values()))
+
+    def testMixed(self):
+        with listen() as server:
+            accessible = (HOST, server.getsockname()[1])
+            refused = (HOST, closedPort())
+            unresponsive = self.createUnresponsive(1)[0]
+            results = PortProber(4, 0.5).probe([unresponsive, refused, accessible])
+
+        self.assertEqual(len(results), 3)
+        self.assertGreaterEqual(results[accessible].ping, 0)
+        self.assertEqual(results[refused].ping, -1)
+        self.assertEqual(results[unresponsive].ping, -1)
+
+    def testConcurrency(self):
+        # Each pending connection blocks a slot until it times out, six
+        # addresses with two slots take three timeouts
+        addresses = self.createUnresponsive(6)
+        prober = CountingProber(2, 0.3)
+        started = time.monotonic()
+        results = prober.probe(addresses)
+        duration = time.monotonic() - started
+
+        self.assertEqual(len(results), 6)
+        self.assertTrue(all(result.ping == -1 for result in results.values()))
+        self.assertEqual(prober.maxPending, 2)
+        self.assertGreaterEqual(duration, 0.9)
+        self.assertLess(duration, 1.8)
+
+    def testConcurrencyAccessible(self):
+        servers = [listen() for _ in range(20)]
+        try:
+            addresses = [(HOST, server.getsockname()[1]) for server in servers]
+            prober = CountingProber(3, 5)
+            results = prober.probe(addresses)
+        finally:
+            for server in servers:
+                server.close()
+
+        self.assertEqual(len(results), 20)
+        self.assertTrue(all(result.ping >= 0 for result in results.values()))
+        self.assertLessEqual(prober.maxPending, 3)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,149 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include "batch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+namespace EventScore {
+
+
+namespace {
+
+
+// Origins a worker takes at once, keeps the shared counter cold
+constexpr size_t ChunkSize = 8;
+
+
+}
+
+
+BatchEvaluator::BatchEvaluator(const string &type, const Config::Config &config,
+                               size_t threads) {
+	if ( !threads ) {
+		threads = max(thread::hardware_concurrency(), 1u);
+	}
+
+	for ( size_t i = 0; i < threads; ++i ) {
+		Client::ScoreProcessorPtr processor = Client::ScoreProcessorFactory::Create(type.c_str());
+		if ( !processor ) {
+			throw runtime_error("unknown score processor " + type);
+		}
+
+		if ( !processor->setup(config) ) {
+			throw runtime_error("failed to set up score processor " + type);
+		}
+
+		_processors.push_back(processor);
+	}
+
+	for ( auto &processor : _processors ) {
+		_workers.emplace_back(&BatchEvaluator::run, this, processor.get());
+	}
+}
+
+
+BatchEvaluator::~BatchEvaluator() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stopping = true;
+	}
+
+	_batchAvailable.notify_all();
+
+	for ( auto &worker : _workers ) {
+		worker.join();
+	}
+}
+
+
+void BatchEvaluator::evaluate(const vector<DataModel::Origin*> &origins,
+                              vector<double> &scores) {
+	scores.resize(origins.size());
+	if ( origins.empty() ) {
+		return;
+	}
+
+	unique_lock<mutex> lock(_mutex);
+	_origins = &origins;
+	_scores = scores.data();
+	_next = 0;
+	_error = nullptr;
+	_busy = _workers.size();
+	++_generation;
+	_batchAvailable.notify_all();
+
+	_batchDone.wait(lock, [this] { return !_busy; });
+	_origins = nullptr;
+	_scores = nullptr;
+
+	if ( _error ) {
+		rethrow_exception(_error);
+	}
+}
+
+
+void BatchEvaluator::run(Client::ScoreProcessor *processor) {
+	size_t generation = 0;
+
+	while ( true ) {
+		{
+			unique_lock<mutex> lock(_mutex);
+			_batchAvailable.wait(lock, [&] { return _stopping || _generation != generation; });
+			if ( _stopping ) {
+				return;
+			}
+			generation = _generation;
+		}
+
+		const auto &origins = *_origins;
+
+		try {
+			while ( true ) {
+				size_t begin = _next.fetch_add(ChunkSize, memory_order_relaxed);
+				if ( begin >= origins.size() ) {
+					break;
+				}
+
+				size_t end = min(begin + ChunkSize, origins.size());
+				for ( size_t i = begin; i < end; ++i ) {
+					_scores[i] = processor->evaluate(origins[i]);
+				}
+			}
+		}
+		catch ( ... ) {
+			lock_guard<mutex> lock(_mutex);
+			if ( !_error ) {
+				_error = current_exception();
+			}
+			// The other workers finish the remaining origins
+		}
+
+		lock_guard<mutex> lock(_mutex);
+		if ( !--_busy ) {
+			_batchDone.notify_one();
+		}
+	}
+}
+
+
+}
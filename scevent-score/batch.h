@@ -0,0 +1,119 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#ifndef SEISCOMP_TEMPLATES_EVENTSCORE_BATCH_H
+#define SEISCOMP_TEMPLATES_EVENTSCORE_BATCH_H
+
+
+#include <seiscomp/config/config.h>
+#include <seiscomp/datamodel/origin.h>
+#include <seiscomp/plugins/events/scoreprocessor.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace EventScore {
+
+
+/**
+ * @brief Evaluates batches of origins in a fixed pool of threads, e.g.
+ *        when all origins of an event are scored after a restart or
+ *        during a playback.
+ *
+ * Each worker owns a score processor created from the factory and set up
+ * with the given configuration. Processors therefore need not support
+ * concurrent calls, but their instances must not share mutable state.
+ * This is the case for the score processor of this plugin. The scores
+ * equal those of a single processor.
+ *
+ * @code
+ * EventScore::BatchEvaluator batch("template", configuration(), 4);
+ * vector<double> scores;
+ * batch.evaluate(origins, scores);
+ * @endcode
+ */
+class BatchEvaluator {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief C'tor
+		 * @param type The registered score processor, e.g. "template"
+		 * @param config The configuration of the processors
+		 * @param threads The number of worker threads, 0 uses the number
+		 *                of cores
+		 * @throws std::runtime_error if a processor cannot be created or
+		 *         set up
+		 */
+		BatchEvaluator(const std::string &type, const Seiscomp::Config::Config &config,
+		               size_t threads = 0);
+
+		//! D'tor, joins the workers
+		~BatchEvaluator();
+
+		BatchEvaluator(const BatchEvaluator &) = delete;
+		BatchEvaluator &operator=(const BatchEvaluator &) = delete;
+
+
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief Scores a batch of origins and blocks until all are done.
+		 * Calls must not overlap. An exception of a processor is rethrown.
+		 * @param origins The origins to be evaluated
+		 * @param scores Receives the score of each origin in input order
+		 */
+		void evaluate(const std::vector<Seiscomp::DataModel::Origin*> &origins,
+		              std::vector<double> &scores);
+
+		size_t threads() const { return _workers.size(); }
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		void run(Seiscomp::Client::ScoreProcessor *processor);
+
+		std::vector<Seiscomp::Client::ScoreProcessorPtr>  _processors;
+		std::vector<std::thread>                          _workers;
+		std::mutex                                        _mutex;
+		std::condition_variable                           _batchAvailable;
+		std::condition_variable                           _batchDone;
+		//! Incremented per batch, wakes the workers
+		size_t                                            _generation{0};
+		size_t                                            _busy{0};
+		bool                                              _stopping{false};
+		const std::vector<Seiscomp::DataModel::Origin*>  *_origins{nullptr};
+		double                                           *_scores{nullptr};
+		std::atomic<size_t>                               _next{0};
+		std::exception_ptr                                _error;
+};
+
+
+}
+
+
+#endif
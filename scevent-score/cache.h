@@ -0,0 +1,131 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_EVENTSCORE_CACHE_H
+#define SEISCOMP_TEMPLATES_EVENTSCORE_CACHE_H
+
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+namespace EventScore {
+
+
+/**
+ * @brief A bounded cache which evicts the least recently used entry.
+ *
+ * @code
+ * LRUCache<Entry> cache(1000);
+ * Entry *entry = cache.find(origin->publicID());
+ * if ( !entry ) {
+ *     entry = &cache.insert(origin->publicID());
+ * }
+ * @endcode
+ */
+template <typename Value>
+class LRUCache {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		//! C'tor
+		explicit LRUCache(size_t capacity = 0) : _capacity(capacity) {}
+
+
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		//! Sets the maximum number of entries, zero disables the cache
+		void setCapacity(size_t capacity) {
+			_capacity = capacity;
+			while ( _entries.size() > _capacity ) {
+				evict();
+			}
+		}
+
+		size_t capacity() const { return _capacity; }
+		size_t size() const { return _entries.size(); }
+
+		//! Returns the entry of a key and marks it as most recently used
+		Value *find(const std::string &key) {
+			auto it = _index.find(key);
+			if ( it == _index.end() ) {
+				return nullptr;
+			}
+
+			_entries.splice(_entries.begin(), _entries, it->second);
+			return &it->second->second;
+		}
+
+		/**
+		 * @brief Inserts or resets the entry of a key. If the cache is
+		 *        full, the least recently used entry is evicted.
+		 * The returned reference stays valid until the entry is evicted.
+		 * With a capacity of zero the entry is evicted with the next
+		 * insert.
+		 */
+		Value &insert(const std::string &key) {
+			auto it = _index.find(key);
+			if ( it != _index.end() ) {
+				_entries.splice(_entries.begin(), _entries, it->second);
+				it->second->second = Value();
+				return it->second->second;
+			}
+
+			while ( !_entries.empty() && _entries.size() >= _capacity ) {
+				evict();
+			}
+
+			_entries.emplace_front(key, Value());
+			_index[key] = _entries.begin();
+			return _entries.front().second;
+		}
+
+		void clear() {
+			_index.clear();
+			_entries.clear();
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private methods
+	// ------------------------------------------------------------------
+	private:
+		void evict() {
+			_index.erase(_entries.back().first);
+			_entries.pop_back();
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		using Entries = std::list<std::pair<std::string, Value>>;
+
+		size_t                                                        _capacity;
+		Entries                                                       _entries;
+		std::unordered_map<std::string, typename Entries::iterator> _index;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,471 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include "expression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+
+using namespace std;
+
+
+namespace EventScore {
+
+
+namespace {
+
+
+// The maximum stack depth of a program
+constexpr size_t MaxDepth = 32;
+// The maximum nesting while parsing and the maximum height of the syntax
+// tree, both are processed recursively
+constexpr int MaxNesting = 100;
+
+
+}
+
+
+struct Expression::Node {
+	Op                     op;
+	int                    index{0};
+	int                    literal{0};
+	double                 value{0};
+	int                    height{1};
+	unique_ptr<Node>       children[2];
+
+	bool isConst() const { return op == Op::Const; }
+};
+
+
+/**
+ * @brief Recursive descent parser which builds the syntax tree and folds
+ *        constant subexpressions while doing so.
+ */
+class Expression::Parser {
+	public:
+		using NodePtr = unique_ptr<Node>;
+
+		Parser(Expression &expr, const string &text)
+		: _expr(expr), _text(text) {}
+
+		NodePtr parse() {
+			NodePtr node = comparison();
+			skipSpace();
+			if ( _pos < _text.size() ) {
+				fail("unexpected character");
+			}
+			return node;
+		}
+
+	private:
+		// comparison := sum [('<'|'>') sum]
+		NodePtr comparison() {
+			Nesting nesting(*this);
+			NodePtr left = sum();
+			if ( accept('<') ) {
+				return binary(Op::Less, std::move(left), sum());
+			}
+			if ( accept('>') ) {
+				return binary(Op::Greater, std::move(left), sum());
+			}
+			return left;
+		}
+
+		// sum := term {('+'|'-') term}
+		NodePtr sum() {
+			NodePtr left = term();
+			while ( true ) {
+				if ( accept('+') ) {
+					left = binary(Op::Add, std::move(left), term());
+				}
+				else if ( accept('-') ) {
+					left = binary(Op::Sub, std::move(left), term());
+				}
+				else {
+					return left;
+				}
+			}
+		}
+
+		// term := unary {('*'|'/') unary}
+		NodePtr term() {
+			NodePtr left = unary();
+			while ( true ) {
+				if ( accept('*') ) {
+					left = binary(Op::Mul, std::move(left), unary());
+				}
+				else if ( accept('/') ) {
+					left = binary(Op::Div, std::move(left), unary());
+				}
+				else {
+					return left;
+				}
+			}
+		}
+
+		// unary := '-' unary | primary
+		NodePtr unary() {
+			if ( accept('-') ) {
+				Nesting nesting(*this);
+				return fold(make(Op::Neg, unary()));
+			}
+			return primary();
+		}
+
+		// primary := number | '(' comparison ')' | name | name '(' args ')'
+		NodePtr primary() {
+			skipSpace();
+
+			if ( accept('(') ) {
+				NodePtr node = comparison();
+				expect(')');
+				return node;
+			}
+
+			if ( _pos < _text.size()
+			  && (isdigit(_text[_pos]) || _text[_pos] == '.') ) {
+				const char *start = _text.c_str() + _pos;
+				char *end;
+				double value = strtod(start, &end);
+				if ( end == start ) {
+					fail("invalid number");
+				}
+				if ( !isfinite(value) ) {
+					fail("number out of range");
+				}
+				_pos += end - start;
+				return constant(value);
+			}
+
+			string name = identifier();
+			if ( name.empty() ) {
+				fail("expected a number, a name or '('");
+			}
+
+			if ( !accept('(') ) {
+				auto it = find(_expr._variables.begin(), _expr._variables.end(), name);
+				if ( it == _expr._variables.end() ) {
+					fail("unknown variable '" + name + "'");
+				}
+
+				auto node = make(Op::Load);
+				node->index = static_cast<int>(it - _expr._variables.begin());
+				return node;
+			}
+
+			auto it = find(_expr._strings.begin(), _expr._strings.end(), name);
+			if ( it != _expr._strings.end() ) {
+				auto node = make(Op::Match);
+				node->index = static_cast<int>(it - _expr._strings.begin());
+				node->literal = literal();
+				expect(')');
+				return node;
+			}
+
+			if ( name == "min" || name == "max" ) {
+				NodePtr a = comparison();
+				expect(',');
+				NodePtr b = comparison();
+				expect(')');
+				return binary(name == "min" ? Op::Min : Op::Max, std::move(a), std::move(b));
+			}
+
+			Op op;
+			if ( name == "abs" ) {
+				op = Op::Abs;
+			}
+			else if ( name == "sqrt" ) {
+				op = Op::Sqrt;
+			}
+			else if ( name == "log" ) {
+				op = Op::Log;
+			}
+			else {
+				fail("unknown function '" + name + "'");
+			}
+
+			NodePtr arg = comparison();
+			expect(')');
+			return fold(make(op, std::move(arg)));
+		}
+
+		//! Parses a quoted string and returns its index in the literal table
+		int literal() {
+			skipSpace();
+			if ( _pos >= _text.size() || _text[_pos] != '"' ) {
+				fail("expected a quoted string");
+			}
+
+			size_t end = _text.find('"', _pos + 1);
+			if ( end == string::npos ) {
+				fail("unterminated string");
+			}
+
+			string value = _text.substr(_pos + 1, end - _pos - 1);
+			_pos = end + 1;
+
+			auto &literals = _expr._literals;
+			auto it = find(literals.begin(), literals.end(), value);
+			if ( it != literals.end() ) {
+				return static_cast<int>(it - literals.begin());
+			}
+
+			literals.push_back(value);
+			return static_cast<int>(literals.size()) - 1;
+		}
+
+		string identifier() {
+			skipSpace();
+			size_t start = _pos;
+			while ( _pos < _text.size()
+			     && (isalnum(_text[_pos]) || _text[_pos] == '_') ) {
+				++_pos;
+			}
+			return _text.substr(start, _pos - start);
+		}
+
+		NodePtr make(Op op, NodePtr a = nullptr, NodePtr b = nullptr) {
+			NodePtr node(new Node);
+			node->op = op;
+			node->children[0] = std::move(a);
+			node->children[1] = std::move(b);
+
+			for ( const auto &child : node->children ) {
+				if ( child ) {
+					node->height = max(node->height, child->height + 1);
+				}
+			}
+
+			// Long chains like a+a+...+a are parsed iteratively but emitted
+			// and destroyed recursively
+			if ( node->height > MaxNesting ) {
+				fail("expression too deeply nested");
+			}
+
+			return node;
+		}
+
+		NodePtr constant(double value) {
+			NodePtr node = make(Op::Const);
+			node->value = value;
+			return node;
+		}
+
+		NodePtr binary(Op op, NodePtr a, NodePtr b) {
+			return fold(make(op, std::move(a), std::move(b)));
+		}
+
+		//! Replaces an operation on constants by its result, results like
+		//! 1/0 or log(-1) are rejected
+		NodePtr fold(NodePtr node) {
+			const Node *a = node->children[0].get();
+			const Node *b = node->children[1].get();
+
+			if ( !a->isConst() || (b && !b->isConst()) ) {
+				return node;
+			}
+
+			double x = a->value, y = b ? b->value : 0, result;
+
+			switch ( node->op ) {
+				case Op::Neg: result = -x; break;
+				case Op::Abs: result = fabs(x); break;
+				case Op::Sqrt: result = sqrt(x); break;
+				case Op::Log: result = log(x); break;
+				case Op::Add: result = x + y; break;
+				case Op::Sub: result = x - y; break;
+				case Op::Mul: result = x * y; break;
+				case Op::Div: result = x / y; break;
+				case Op::Less: result = x < y ? 1 : 0; break;
+				case Op::Greater: result = x > y ? 1 : 0; break;
+				case Op::Min: result = min(x, y); break;
+				case Op::Max: result = max(x, y); break;
+				default: return node;
+			}
+
+			if ( !isfinite(result) ) {
+				fail("constant subexpression is not finite");
+			}
+
+			return constant(result);
+		}
+
+		void skipSpace() {
+			while ( _pos < _text.size() && isspace(_text[_pos]) ) {
+				++_pos;
+			}
+		}
+
+		bool accept(char c) {
+			skipSpace();
+			if ( _pos < _text.size() && _text[_pos] == c ) {
+				++_pos;
+				return true;
+			}
+			return false;
+		}
+
+		void expect(char c) {
+			if ( !accept(c) ) {
+				fail(string("expected '") + c + "'");
+			}
+		}
+
+		[[noreturn]] void fail(const string &message) const {
+			throw runtime_error(message + " at position " + to_string(_pos + 1));
+		}
+
+	private:
+		//! Counts the recursion of the parser
+		struct Nesting {
+			explicit Nesting(Parser &parser) : _parser(parser) {
+				if ( ++_parser._nesting > MaxNesting ) {
+					_parser.fail("expression too deeply nested");
+				}
+			}
+
+			~Nesting() { --_parser._nesting; }
+
+			Parser &_parser;
+		};
+
+		Expression   &_expr;
+		const string &_text;
+		size_t        _pos{0};
+		int           _nesting{0};
+};
+
+
+Expression::Expression(vector<string> variables, vector<string> strings)
+: _variables(std::move(variables)), _strings(std::move(strings)) {}
+
+
+bool Expression::compile(const string &text, string *error) {
+	clear();
+
+	try {
+		Parser parser(*this, text);
+		auto root = parser.parse();
+		emit(*root, 0);
+
+		if ( _depth > MaxDepth ) {
+			throw runtime_error("expression too deeply nested");
+		}
+	}
+	catch ( exception &e ) {
+		clear();
+		if ( error ) {
+			*error = e.what();
+		}
+		return false;
+	}
+
+	return true;
+}
+
+
+void Expression::clear() {
+	_program.clear();
+	_literals.clear();
+	_depth = 0;
+}
+
+
+void Expression::emit(const Node &node, size_t depth) {
+	// Postfix order, each operand raises the stack by one
+	size_t operands = 0;
+	for ( const auto &child : node.children ) {
+		if ( child ) {
+			emit(*child, depth + operands);
+			++operands;
+		}
+	}
+
+	_program.push_back({ node.op, node.index, node.literal, node.value });
+	_depth = max(_depth, depth + max(operands, size_t(1)));
+}
+
+
+bool Expression::usesString(size_t index) const {
+	return any_of(_program.begin(), _program.end(), [index](const Instruction &i) {
+		return i.op == Op::Match && i.index == static_cast<int>(index);
+	});
+}
+
+
+double Expression::evaluate(const double *variables, const string *strings) const {
+	double stack[MaxDepth];
+	double *top = stack - 1;
+
+	for ( const Instruction &i : _program ) {
+		switch ( i.op ) {
+			case Op::Const:
+				*++top = i.value;
+				break;
+			case Op::Load:
+				*++top = variables[i.index];
+				break;
+			case Op::Match:
+				*++top = strings[i.index] == _literals[i.literal] ? 1 : 0;
+				break;
+			case Op::Neg:
+				*top = -*top;
+				break;
+			case Op::Abs:
+				*top = fabs(*top);
+				break;
+			case Op::Sqrt:
+				*top = sqrt(*top);
+				break;
+			case Op::Log:
+				*top = log(*top);
+				break;
+			case Op::Add:
+				--top; *top += top[1];
+				break;
+			case Op::Sub:
+				--top; *top -= top[1];
+				break;
+			case Op::Mul:
+				--top; *top *= top[1];
+				break;
+			case Op::Div:
+				--top; *top /= top[1];
+				break;
+			case Op::Less:
+				--top; *top = *top < top[1] ? 1 : 0;
+				break;
+			case Op::Greater:
+				--top; *top = *top > top[1] ? 1 : 0;
+				break;
+			case Op::Min:
+				--top; *top = min(*top, top[1]);
+				break;
+			case Op::Max:
+				--top; *top = max(*top, top[1]);
+				break;
+		}
+	}
+
+	return _program.empty() ? 0 : *top;
+}
+
+
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_EVENTSCORE_EXPRESSION_H
+#define SEISCOMP_TEMPLATES_EVENTSCORE_EXPRESSION_H
+
+
+#include <string>
+#include <vector>
+
+
+namespace EventScore {
+
+
+/**
+ * @brief A score formula which is compiled once into a compact bytecode.
+ *
+ * @code
+ * Expression expr({"phases", "gap"}, {"agency"});
+ * expr.compile("phases - 0.1*gap + 5*agency(\"XY\")", &error);
+ * double vars[] = { 23, 80 };
+ * string strings[] = { "XY" };
+ * double score = expr.evaluate(vars, strings);
+ * @endcode
+ *
+ * Supported are numbers, the given variables, + - * /, unary minus,
+ * < and > (1 if true, 0 otherwise), parentheses and the functions
+ * min(a,b), max(a,b), abs(a), sqrt(a) and log(a). Each string attribute
+ * is a function which takes a quoted literal and returns 1 if the
+ * attribute equals the literal and 0 otherwise. Subexpressions without
+ * variables are folded into constants at compile time, a constant which
+ * is not finite like 1/0 or log(-1) is an error. So is nesting deeper
+ * than 100 levels.
+ */
+class Expression {
+	// ------------------------------------------------------------------
+	//  X'truction
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief C'tor
+		 * @param variables The names of the numeric variables in the order
+		 *                  they are passed to evaluate()
+		 * @param strings The names of the string attributes in the order
+		 *                they are passed to evaluate()
+		 */
+		Expression(std::vector<std::string> variables = {},
+		           std::vector<std::string> strings = {});
+
+
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		/**
+		 * @brief Compiles an expression and replaces the current program.
+		 * @param text The expression
+		 * @param error Receives the error message if not nullptr
+		 * @return false on syntax errors, non-finite constants and too
+		 *         deep nesting, the program is empty then
+		 */
+		bool compile(const std::string &text, std::string *error = nullptr);
+
+		//! Removes the compiled program
+		void clear();
+
+		//! Returns true if no expression is compiled
+		bool empty() const { return _program.empty(); }
+
+		//! Returns true if the expression uses the given string attribute
+		bool usesString(size_t index) const;
+
+		/**
+		 * @brief Evaluates the compiled expression.
+		 * @param variables The values of the variables
+		 * @param strings The values of the string attributes
+		 */
+		double evaluate(const double *variables, const std::string *strings) const;
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		enum class Op : unsigned char {
+			Const, Load, Match,
+			Neg, Abs, Sqrt, Log,
+			Add, Sub, Mul, Div, Less, Greater, Min, Max
+		};
+
+		struct Instruction {
+			Op     op;
+			//! The variable or string attribute
+			int    index;
+			//! The literal a string attribute is matched against
+			int    literal;
+			double value;
+		};
+
+		struct Node;
+		class Parser;
+
+		//! Appends the program of a node which starts at the given stack depth
+		void emit(const Node &node, size_t depth);
+
+		std::vector<std::string> _variables;
+		std::vector<std::string> _strings;
+		std::vector<std::string> _literals;
+		std::vector<Instruction> _program;
+		size_t                   _depth{0};
+};
+
+
+}
+
+
+#endif
@@ -18,15 +18,266 @@
 #include <seiscomp/logging/log.h>
 #include <seiscomp/core/plugin.h>
 #include <seiscomp/core/strings.h>
+#include <seiscomp/client/inventory.h>
+#include <seiscomp/datamodel/focalmechanism.h>
+#include <seiscomp/datamodel/inventory.h>
+#include <seiscomp/datamodel/momenttensor.h>
 #include <seiscomp/datamodel/origin.h>
+#include <seiscomp/datamodel/pick.h>
+#include <seiscomp/math/geo.h>
 #include <seiscomp/plugins/events/scoreprocessor.h>
 
+#include "cache.h"
+#include "expression.h"
+#include "weighttable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
 
 namespace {
 
 
 using namespace std;
 using namespace Seiscomp;
+using namespace EventScore;
+
+
+// Number of azimuthal sectors used to rate the station distribution
+constexpr int AzimuthSectors = 16;
+
+
+//! Reads an optional attribute, returns false if it is not set
+template <typename Getter>
+bool optional(Getter get, double &value) {
+	try {
+		value = get();
+		return true;
+	}
+	catch ( ... ) {
+		return false;
+	}
+}
+
+
+/**
+ * @brief The score components of an origin. The order of the numeric
+ *        components is the order of the expression variables, see
+ *        OriginVariables.
+ */
+struct OriginComponents {
+	int    phases{0};
+	double gap{360};
+	double rms{0};
+	int    sectors{0};
+	int    magnitudes{0};
+	//! The configured weight of the agency
+	double agencyWeight{0};
+	//! The configured weight of the author
+	double authorWeight{0};
+};
+
+
+/**
+ * @brief Partial aggregates of the arrivals of an origin.
+ * Origins are rarely modified after they were sent, but arrivals may be
+ * appended and magnitudes are added later. New arrivals are added to the
+ * aggregates without visiting the already processed ones. Changed or
+ * removed arrivals come with a relocation which changes the fingerprint
+ * of the origin, the aggregates are then rebuilt.
+ */
+struct ArrivalAggregates {
+	size_t         arrivals{0};
+	int            phases{0};
+	double         sumSquares{0};
+	int            residuals{0};
+	uint32_t       sectors{0};
+	double         gap{360};
+	//! The azimuths of the used arrivals
+	vector<double> azimuths;
+
+	void clear() {
+		arrivals = 0;
+		phases = 0;
+		sumSquares = 0;
+		residuals = 0;
+		sectors = 0;
+		gap = 360;
+		azimuths.clear();
+	}
+};
+
+
+/**
+ * @brief The attributes of an origin which change when it is relocated.
+ * The modification time is usually not set, hence the content is
+ * compared. Unset attributes are NaN.
+ */
+struct OriginFingerprint {
+	double values[7];
+
+	bool operator==(const OriginFingerprint &other) const {
+		return memcmp(values, other.values, sizeof(values)) == 0;
+	}
+
+	bool operator!=(const OriginFingerprint &other) const {
+		return !(*this == other);
+	}
+};
+
+
+struct CachedScore {
+	OriginFingerprint fingerprint;
+	size_t            magnitudes{0};
+	ArrivalAggregates aggregates;
+	double            score{0};
+};
+
+
+//! Returns the fingerprint of an origin, it throws no exceptions for
+//! the attributes which locators always set
+OriginFingerprint fingerprint(const DataModel::Origin *origin) {
+	OriginFingerprint fp;
+	fill(begin(fp.values), end(fp.values), numeric_limits<double>::quiet_NaN());
+
+	fp.values[0] = static_cast<double>(origin->time().value());
+	fp.values[1] = origin->latitude().value();
+	fp.values[2] = origin->longitude().value();
+	optional([origin] { return origin->depth().value(); }, fp.values[3]);
+
+	try {
+		const DataModel::OriginQuality &quality = origin->quality();
+		optional([&] { return quality.standardError(); }, fp.values[4]);
+		optional([&] { return quality.azimuthalGap(); }, fp.values[5]);
+		optional([&] { return quality.usedPhaseCount(); }, fp.values[6]);
+	}
+	catch ( ... ) {}
+
+	return fp;
+}
+
+
+/**
+ * @brief Returns the largest gap between azimuths in [0,360) in O(n).
+ *
+ * The azimuths are put into as many buckets as there are azimuths. The
+ * largest gap is at least one bucket wide, hence it lies between the
+ * maximum of an occupied bucket and the minimum of the next occupied one
+ * and the gaps within the buckets do not matter.
+ */
+double azimuthalGap(const vector<double> &azimuths) {
+	struct Bucket {
+		double min;
+		double max;
+	};
+
+	size_t n = azimuths.size();
+	if ( n < 2 ) {
+		return 360;
+	}
+
+	// Reused by all calls of a thread, see BatchEvaluator
+	thread_local vector<Bucket> buckets;
+	buckets.assign(n, { 360.0, -1.0 });
+
+	double scale = n / 360.0;
+	for ( double azimuth : azimuths ) {
+		Bucket &bucket = buckets[min(static_cast<size_t>(azimuth * scale), n - 1)];
+		bucket.min = min(bucket.min, azimuth);
+		bucket.max = max(bucket.max, azimuth);
+	}
+
+	double first = -1, last = -1, gap = 0;
+	for ( const Bucket &bucket : buckets ) {
+		if ( bucket.max < 0 ) {
+			continue;
+		}
+
+		if ( last < 0 ) {
+			first = bucket.min;
+		}
+		else {
+			gap = max(gap, bucket.min - last);
+		}
+
+		last = bucket.max;
+	}
+
+	return max(gap, first + 360.0 - last);
+}
+
+
+//! The variables of the score expression
+const vector<string> OriginVariables = {
+	"phases", "gap", "rms", "sectors", "magnitudes",
+	"agencyWeight", "authorWeight"
+};
+
+//! The string attributes of the score expression
+const vector<string> OriginStrings = {
+	"agency", "author"
+};
+
+
+struct StationLocation {
+	double latitude{0};
+	double longitude{0};
+	double start{-1E300};
+};
+
+
+/**
+ * @brief Derived quality metrics of a moment tensor.
+ */
+struct MomentTensorMetrics {
+	//! The size of the data used list the metrics were derived from
+	size_t dataUsed{0};
+	double clvd{0};
+	double varianceReduction{0};
+	int    stations{0};
+};
+
+
+/**
+ * @brief The score components of a focal mechanism.
+ */
+struct MechanismComponents {
+	double              polarities{0};
+	double              misfit{0};
+	double              agencyWeight{0};
+	double              authorWeight{0};
+	//! The metrics of the best moment tensor
+	MomentTensorMetrics momentTensor;
+};
+
+
+/**
+ * @brief The weights of the score components.
+ */
+struct ScoreWeights {
+	double phases{1.0};
+	double gap{0.05};
+	double rms{5.0};
+	double sectors{1.0};
+	double magnitudes{1.0};
+};
+
+
+/**
+ * @brief The weights of the focal mechanism score components.
+ */
+struct MechanismWeights {
+	double polarities{1.0};
+	double misfit{10.0};
+	double clvd{10.0};
+	double varianceReduction{0.1};
+	double stations{1.0};
+};
 
 
 /**
@@ -60,16 +311,106 @@ class ScoreProcessor : public Client::ScoreProcessor {
 	public:
 		//! Setup all configuration parameters
 		bool setup(const Config::Config &config) override {
+			string expression;
+			try {
+				expression = config.getString("scoreProcessors.template.expression");
+			}
+			catch ( ... ) {}
+
+			_expression.clear();
+			if ( !expression.empty() ) {
+				string error;
+				if ( !_expression.compile(expression, &error) ) {
+					SEISCOMP_ERROR("scoreProcessors.template.expression: %s",
+					               error);
+					return false;
+				}
+			}
+
+			_expressionUsesCreationInfo = _expression.usesString(0)
+			                           || _expression.usesString(1);
+
+			try {
+				_weights.phases = config.getDouble("scoreProcessors.template.weights.phases");
+			}
+			catch ( ... ) {}
+
+			try {
+				_weights.gap = config.getDouble("scoreProcessors.template.weights.gap");
+			}
+			catch ( ... ) {}
+
 			try {
-				_param1 = config.getDouble("scoreProcessors.template.param1");
+				_weights.rms = config.getDouble("scoreProcessors.template.weights.rms");
 			}
 			catch ( ... ) {}
 
 			try {
-				_param2 = config.getDouble("scoreProcessors.template.param2");
+				_weights.sectors = config.getDouble("scoreProcessors.template.weights.sectors");
 			}
 			catch ( ... ) {}
 
+			try {
+				_weights.magnitudes = config.getDouble("scoreProcessors.template.weights.magnitudes");
+			}
+			catch ( ... ) {}
+
+			try {
+				_mechanismWeights.polarities = config.getDouble("scoreProcessors.template.mechanismWeights.polarities");
+			}
+			catch ( ... ) {}
+
+			try {
+				_mechanismWeights.misfit = config.getDouble("scoreProcessors.template.mechanismWeights.misfit");
+			}
+			catch ( ... ) {}
+
+			try {
+				_mechanismWeights.clvd = config.getDouble("scoreProcessors.template.mechanismWeights.clvd");
+			}
+			catch ( ... ) {}
+
+			try {
+				_mechanismWeights.varianceReduction = config.getDouble("scoreProcessors.template.mechanismWeights.varianceReduction");
+			}
+			catch ( ... ) {}
+
+			try {
+				_mechanismWeights.stations = config.getDouble("scoreProcessors.template.mechanismWeights.stations");
+			}
+			catch ( ... ) {}
+
+			if ( !readWeights(config, "scoreProcessors.template.agencyWeights", _agencies)
+			  || !readWeights(config, "scoreProcessors.template.authorWeights", _authors) ) {
+				return false;
+			}
+
+			_trace = false;
+			try {
+				_trace = config.getBool("scoreProcessors.template.trace");
+			}
+			catch ( ... ) {}
+
+			int cacheSize = 1000;
+			try {
+				cacheSize = config.getInt("scoreProcessors.template.cacheSize");
+			}
+			catch ( ... ) {}
+
+			if ( cacheSize < 0 ) {
+				SEISCOMP_ERROR("scoreProcessors.template.cacheSize: invalid value %d",
+				               cacheSize);
+				return false;
+			}
+
+			// Scores of other weights or expressions are invalid
+			_cache.clear();
+			_cache.setCapacity(static_cast<size_t>(cacheSize));
+			_momentTensors.clear();
+			_momentTensors.setCapacity(static_cast<size_t>(cacheSize));
+
+			loadStations();
+
 			return true;
 		}
 
@@ -82,7 +423,41 @@ class ScoreProcessor : public Client::ScoreProcessor {
 		 * @return The score
 		 */
 		double evaluate(DataModel::Origin *origin) override {
-			return 0;
+			if ( !_cache.capacity() || origin->publicID().empty() ) {
+				_scratch.clear();
+				OriginComponents components = collect(origin, _scratch);
+				double result = score(origin, components);
+				if ( _trace ) {
+					trace(origin, components, result);
+				}
+				return result;
+			}
+
+			OriginFingerprint fp = fingerprint(origin);
+			CachedScore *cached = _cache.find(origin->publicID());
+
+			if ( !cached ) {
+				cached = &_cache.insert(origin->publicID());
+			}
+			else if ( cached->fingerprint != fp
+			       || origin->arrivalCount() < cached->aggregates.arrivals ) {
+				// The origin was relocated, start from scratch
+				cached->aggregates.clear();
+			}
+			else if ( origin->arrivalCount() == cached->aggregates.arrivals
+			       && origin->magnitudeCount() == cached->magnitudes ) {
+				return cached->score;
+			}
+
+			cached->fingerprint = fp;
+			cached->magnitudes = origin->magnitudeCount();
+			OriginComponents components = collect(origin, cached->aggregates);
+			cached->score = score(origin, components);
+			if ( _trace ) {
+				trace(origin, components, cached->score);
+			}
+
+			return cached->score;
 		}
 
 		/**
@@ -94,7 +469,367 @@ class ScoreProcessor : public Client::ScoreProcessor {
 		 * @return The score
 		 */
 		double evaluate(DataModel::FocalMechanism *fm) override {
-			return 0;
+			MechanismComponents components;
+			optional([fm] { return fm->stationPolarityCount(); }, components.polarities);
+			optional([fm] { return fm->misfit(); }, components.misfit);
+
+			lookupWeights(fm, components.agencyWeight, components.authorWeight);
+
+			double result = _mechanismWeights.polarities * components.polarities
+			              - _mechanismWeights.misfit * components.misfit
+			              + components.agencyWeight
+			              + components.authorWeight;
+
+			// Rate the best moment tensor of the mechanism
+			size_t count = fm->momentTensorCount();
+			double best = 0;
+
+			for ( size_t i = 0; i < count; ++i ) {
+				MomentTensorMetrics mt = metrics(fm->momentTensor(i));
+				double value = _mechanismWeights.varianceReduction * mt.varianceReduction
+				             - _mechanismWeights.clvd * abs(mt.clvd)
+				             + _mechanismWeights.stations * mt.stations;
+				if ( !i || value > best ) {
+					best = value;
+					components.momentTensor = mt;
+				}
+			}
+
+			result += best;
+
+			if ( _trace ) {
+				trace(fm, components, result, count > 0);
+			}
+
+			return result;
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private methods
+	// ------------------------------------------------------------------
+	private:
+		//! Reads a list of "name:weight" items into a weight table
+		static bool readWeights(const Config::Config &config, const string &key,
+		                        WeightTable &table) {
+			vector<string> items;
+			try {
+				items = config.getStrings(key);
+			}
+			catch ( ... ) {}
+
+			WeightTable::Entries entries;
+			for ( const auto &item : items ) {
+				size_t pos = item.rfind(':');
+				double weight;
+
+				if ( pos == string::npos
+				  || !Core::fromString(weight, item.substr(pos + 1)) ) {
+					SEISCOMP_ERROR("%s: invalid item '%s', expected name:weight",
+					               key, item);
+					return false;
+				}
+
+				string name = item.substr(0, pos);
+				entries.emplace_back(Core::trim(name), weight);
+			}
+
+			if ( !table.build(entries) ) {
+				SEISCOMP_ERROR("%s: names must be unique", key);
+				return false;
+			}
+
+			return true;
+		}
+
+		void trace(const DataModel::Origin *origin,
+		           const OriginComponents &components, double score) const {
+			SEISCOMP_INFO("Origin %s: score %.3f, phases %d, gap %.1f, rms %.3f, "
+			              "sectors %d, magnitudes %d, agency %g, author %g",
+			              origin->publicID(), score, components.phases,
+			              components.gap, components.rms, components.sectors,
+			              components.magnitudes, components.agencyWeight,
+			              components.authorWeight);
+		}
+
+		void trace(const DataModel::FocalMechanism *fm,
+		           const MechanismComponents &components, double score,
+		           bool hasMomentTensor) const {
+			if ( !hasMomentTensor ) {
+				SEISCOMP_INFO("Focal mechanism %s: score %.3f, polarities %.0f, "
+				              "misfit %.3f, agency %g, author %g",
+				              fm->publicID(), score, components.polarities,
+				              components.misfit, components.agencyWeight,
+				              components.authorWeight);
+				return;
+			}
+
+			SEISCOMP_INFO("Focal mechanism %s: score %.3f, polarities %.0f, "
+			              "misfit %.3f, agency %g, author %g, "
+			              "variance reduction %.1f, clvd %.3f, stations %d",
+			              fm->publicID(), score, components.polarities,
+			              components.misfit, components.agencyWeight,
+			              components.authorWeight,
+			              components.momentTensor.varianceReduction,
+			              components.momentTensor.clvd,
+			              components.momentTensor.stations);
+		}
+
+		//! Looks up the configured weights of the creator of an object
+		template <typename Object>
+		void lookupWeights(const Object *object, double &agencyWeight,
+		                   double &authorWeight) const {
+			if ( _agencies.empty() && _authors.empty() ) {
+				return;
+			}
+
+			try {
+				const DataModel::CreationInfo &ci = object->creationInfo();
+				agencyWeight = _agencies.lookup(ci.agencyID());
+				authorWeight = _authors.lookup(ci.author());
+			}
+			catch ( ... ) {}
+		}
+
+		/**
+		 * @brief Returns the metrics of a moment tensor.
+		 * The metrics are cached by publicID and derived again if the size
+		 * of the data used list changed. Moment tensors of other agencies
+		 * often lack the variance reduction or the CLVD component, each
+		 * missing attribute costs an exception.
+		 */
+		MomentTensorMetrics metrics(const DataModel::MomentTensor *mt) {
+			if ( !_momentTensors.capacity() || mt->publicID().empty() ) {
+				return computeMetrics(mt);
+			}
+
+			MomentTensorMetrics *metrics = _momentTensors.find(mt->publicID());
+			if ( metrics && metrics->dataUsed == mt->dataUsedCount() ) {
+				return *metrics;
+			}
+
+			if ( !metrics ) {
+				metrics = &_momentTensors.insert(mt->publicID());
+			}
+
+			*metrics = computeMetrics(mt);
+			return *metrics;
+		}
+
+		static MomentTensorMetrics computeMetrics(const DataModel::MomentTensor *mt) {
+			MomentTensorMetrics metrics;
+			metrics.dataUsed = mt->dataUsedCount();
+
+			optional([mt] { return mt->clvd(); }, metrics.clvd);
+			optional([mt] { return mt->varianceReduction(); }, metrics.varianceReduction);
+
+			for ( size_t i = 0; i < metrics.dataUsed; ++i ) {
+				metrics.stations += mt->dataUsed(i)->stationCount();
+			}
+
+			return metrics;
+		}
+
+		/**
+		 * @brief Returns the score components of an origin.
+		 * Arrivals which are not yet part of the aggregates are added in a
+		 * single pass. Origins without arrivals, e.g. imported from other
+		 * agencies, are rated by their quality attributes.
+		 */
+		OriginComponents collect(const DataModel::Origin *origin,
+		                         ArrivalAggregates &aggregates) const {
+			OriginComponents components;
+			components.magnitudes = static_cast<int>(origin->magnitudeCount());
+			lookupWeights(origin, components.agencyWeight, components.authorWeight);
+
+			if ( !origin->arrivalCount() ) {
+				try {
+					const DataModel::OriginQuality &quality = origin->quality();
+					double value;
+					if ( optional([&] { return quality.usedPhaseCount(); }, value) ) {
+						components.phases = static_cast<int>(value);
+					}
+					optional([&] { return quality.azimuthalGap(); }, components.gap);
+					optional([&] { return quality.standardError(); }, components.rms);
+				}
+				catch ( ... ) {}
+				return components;
+			}
+
+			accumulate(origin, aggregates);
+
+			components.phases = aggregates.phases;
+			components.gap = aggregates.gap;
+			components.sectors = __builtin_popcount(aggregates.sectors);
+			if ( aggregates.residuals ) {
+				components.rms = sqrt(aggregates.sumSquares / aggregates.residuals);
+			}
+
+			return components;
+		}
+
+		/**
+		 * @brief Adds the arrivals which are not yet part of the aggregates.
+		 * Arrivals without azimuth get the azimuth of their station if the
+		 * station coordinates and the pick are known, which is not the case
+		 * in scevent, see stationAzimuth().
+		 */
+		void accumulate(const DataModel::Origin *origin,
+		                ArrivalAggregates &aggregates) const {
+			size_t count = origin->arrivalCount();
+			size_t previous = aggregates.azimuths.size();
+
+			for ( size_t i = aggregates.arrivals; i < count; ++i ) {
+				const DataModel::Arrival *arrival = origin->arrival(i);
+
+				double weight = 1.0, value;
+				optional([arrival] { return arrival->weight(); }, weight);
+				if ( weight <= 0 ) {
+					continue;
+				}
+
+				++aggregates.phases;
+
+				if ( optional([arrival] { return arrival->timeResidual(); }, value) ) {
+					aggregates.sumSquares += value * value;
+					++aggregates.residuals;
+				}
+
+				if ( optional([arrival] { return arrival->azimuth(); }, value)
+				  || stationAzimuth(origin, arrival, value) ) {
+					value = fmod(value, 360.0);
+					if ( value < 0 ) {
+						value += 360.0;
+					}
+
+					aggregates.azimuths.push_back(value);
+					aggregates.sectors |= 1u << (static_cast<int>(value * AzimuthSectors / 360.0) % AzimuthSectors);
+				}
+			}
+
+			aggregates.arrivals = count;
+
+			if ( aggregates.azimuths.size() != previous ) {
+				aggregates.gap = azimuthalGap(aggregates.azimuths);
+			}
+		}
+
+		/**
+		 * @brief Computes the azimuth from the origin to the station of an
+		 *        arrival.
+		 * This requires the pick of the arrival in memory and the inventory.
+		 * scevent loads neither, hence this only works if the processor is
+		 * used by an application which does, e.g. a custom tool.
+		 */
+		bool stationAzimuth(const DataModel::Origin *origin,
+		                    const DataModel::Arrival *arrival,
+		                    double &azimuth) const {
+			if ( _stations.empty() ) {
+				return false;
+			}
+
+			DataModel::Pick *pick = DataModel::Pick::Find(arrival->pickID());
+			if ( !pick ) {
+				return false;
+			}
+
+			string key = pick->waveformID().networkCode();
+			key += '.';
+			key += pick->waveformID().stationCode();
+
+			auto it = _stations.find(key);
+			if ( it == _stations.end() ) {
+				return false;
+			}
+
+			double distance, backAzimuth;
+			Math::Geo::delazi(origin->latitude().value(), origin->longitude().value(),
+			                  it->second.latitude, it->second.longitude,
+			                  &distance, &azimuth, &backAzimuth);
+			return true;
+		}
+
+		/**
+		 * @brief Builds the table of station coordinates from the inventory.
+		 * Of several epochs of a station the latest is used. scevent does not
+		 * load the inventory, the table stays empty there and the fallback
+		 * of stationAzimuth() is disabled. This is the normal case and only
+		 * logged at debug level.
+		 */
+		void loadStations() {
+			_stations.clear();
+
+			DataModel::Inventory *inv = Client::Inventory::Instance()->inventory();
+			if ( !inv ) {
+				SEISCOMP_DEBUG("No inventory loaded, azimuths are only taken from arrivals");
+				return;
+			}
+
+			for ( size_t n = 0; n < inv->networkCount(); ++n ) {
+				DataModel::Network *net = inv->network(n);
+				for ( size_t s = 0; s < net->stationCount(); ++s ) {
+					DataModel::Station *sta = net->station(s);
+					StationLocation location;
+
+					try {
+						location.latitude = sta->latitude();
+						location.longitude = sta->longitude();
+					}
+					catch ( ... ) {
+						continue;
+					}
+
+					location.start = static_cast<double>(sta->start());
+
+					auto &entry = _stations[net->code() + "." + sta->code()];
+					if ( location.start >= entry.start ) {
+						entry = location;
+					}
+				}
+			}
+
+			if ( _stations.empty() ) {
+				SEISCOMP_DEBUG("No station coordinates in the inventory, azimuths are "
+				               "only taken from arrivals");
+				return;
+			}
+
+			SEISCOMP_INFO("Loaded coordinates of %d stations, azimuths of arrivals "
+			              "without one are computed from their picks", _stations.size());
+		}
+
+		double score(const DataModel::Origin *origin,
+		             const OriginComponents &components) const {
+			if ( !_expression.empty() ) {
+				double variables[] = {
+					static_cast<double>(components.phases),
+					components.gap,
+					components.rms,
+					static_cast<double>(components.sectors),
+					static_cast<double>(components.magnitudes),
+					components.agencyWeight,
+					components.authorWeight
+				};
+
+				string strings[2];
+				if ( _expressionUsesCreationInfo ) {
+					try {
+						strings[0] = origin->creationInfo().agencyID();
+						strings[1] = origin->creationInfo().author();
+					}
+					catch ( ... ) {}
+				}
+
+				return _expression.evaluate(variables, strings);
+			}
+
+			return _weights.phases * components.phases
+			     - _weights.gap * components.gap
+			     - _weights.rms * components.rms
+			     + _weights.sectors * components.sectors
+			     + _weights.magnitudes * components.magnitudes
+			     + components.agencyWeight
+			     + components.authorWeight;
 		}
 
 
@@ -102,8 +837,23 @@ class ScoreProcessor : public Client::ScoreProcessor {
 	//  Private members
 	// ------------------------------------------------------------------
 	private:
-		string _param1;
-		double _param2{0.0};
+		ScoreWeights                              _weights;
+		Expression                                _expression{OriginVariables, OriginStrings};
+		bool                                      _expressionUsesCreationInfo{false};
+		//! Configured weights by agency ID and author
+		WeightTable                               _agencies;
+		WeightTable                               _authors;
+		//! Logs the components of each computed score
+		bool                                      _trace{false};
+		MechanismWeights                          _mechanismWeights;
+		//! Aggregates reused for origins which are not cached
+		ArrivalAggregates                         _scratch;
+		//! Scores and aggregates of recently evaluated origins by publicID
+		LRUCache<CachedScore>                     _cache{1000};
+		//! Metrics of recently evaluated moment tensors by publicID
+		LRUCache<MomentTensorMetrics>             _momentTensors{1000};
+		//! Station coordinates by network and station code, e.g. "GE.MORC"
+		unordered_map<string, StationLocation>    _stations;
 };
 
 
@@ -111,7 +861,7 @@ class ScoreProcessor : public Client::ScoreProcessor {
 
 
 ADD_SC_PLUGIN(
-	"scevent score plugin template, it does actually nothing",
+	"scevent score plugin template, it scores origins and focal mechanisms",
 	"Jan Becker, gempa GmbH",
 	0, 0, 1
 )
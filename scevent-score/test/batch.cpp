@@ -0,0 +1,138 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+
+#include <seiscomp/config/config.h>
+#include <seiscomp/datamodel/arrival.h>
+#include <seiscomp/datamodel/origin.h>
+#include <seiscomp/plugins/events/scoreprocessor.h>
+
+#include "batch.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr int Origins = 200;
+
+
+DataModel::OriginPtr createOrigin(mt19937 &rng, int index) {
+	uniform_real_distribution<double> azimuth(0, 360);
+	normal_distribution<double> residual(0, 0.5);
+	uniform_int_distribution<int> arrivals(0, 400);
+
+	DataModel::OriginPtr origin = DataModel::Origin::Create("Origin/batch" + to_string(index));
+	origin->setTime(DataModel::TimeQuantity(Core::Time(1700000000.0 + index)));
+	origin->setLatitude(DataModel::RealQuantity(index * 0.1));
+	origin->setLongitude(DataModel::RealQuantity(10));
+	origin->setDepth(DataModel::RealQuantity(10));
+
+	int count = arrivals(rng);
+	for ( int i = 0; i < count; ++i ) {
+		DataModel::ArrivalPtr arrival = new DataModel::Arrival;
+		arrival->setPickID("Pick/" + to_string(index) + "." + to_string(i));
+		arrival->setPhase(DataModel::Phase("P"));
+		arrival->setWeight(i % 5 ? 1.0 : 0.0);
+		arrival->setAzimuth(azimuth(rng));
+		arrival->setTimeResidual(residual(rng));
+		origin->add(arrival.get());
+	}
+
+	// Origins without arrivals are rated by their quality
+	DataModel::OriginQuality quality;
+	quality.setUsedPhaseCount(count ? count : index % 30);
+	quality.setStandardError(0.1 + (index % 10) * 0.1);
+	quality.setAzimuthalGap(index % 360);
+	origin->setQuality(quality);
+	return origin;
+}
+
+
+}
+
+
+/**
+ * Scores a set of origins with a single processor and in batches with
+ * different numbers of threads and requires identical scores in input
+ * order. Each batch runs twice to score the cached origins again.
+ */
+int main() {
+	Config::Config config;
+	Client::ScoreProcessorPtr processor = Client::ScoreProcessorFactory::Create("template");
+	if ( !processor || !processor->setup(config) ) {
+		cerr << "Failed to create the score processor 'template'" << endl;
+		return 1;
+	}
+
+	mt19937 rng(42);
+	vector<DataModel::OriginPtr> store;
+	vector<DataModel::Origin*> origins;
+	for ( int i = 0; i < Origins; ++i ) {
+		store.push_back(createOrigin(rng, i));
+		origins.push_back(store.back().get());
+	}
+
+	vector<double> expected;
+	for ( auto origin : origins ) {
+		expected.push_back(processor->evaluate(origin));
+	}
+
+	bool ok = true;
+
+	for ( size_t threads : { 1, 4, Origins + 10 } ) {
+		EventScore::BatchEvaluator batch("template", config, threads);
+
+		for ( int pass = 0; pass < 2; ++pass ) {
+			vector<double> scores;
+			batch.evaluate(origins, scores);
+
+			if ( scores.size() != expected.size() ) {
+				cerr << threads << " threads: " << scores.size() << " scores for "
+				     << expected.size() << " origins" << endl;
+				ok = false;
+				continue;
+			}
+
+			for ( size_t i = 0; i < scores.size(); ++i ) {
+				if ( scores[i] != expected[i] ) {
+					cerr << threads << " threads, pass " << pass << ": origin " << i
+					     << " scored " << scores[i] << " instead of " << expected[i] << endl;
+					ok = false;
+					break;
+				}
+			}
+		}
+
+		vector<double> scores{1.0};
+		batch.evaluate({}, scores);
+		if ( !scores.empty() ) {
+			cerr << threads << " threads: scores of an empty batch" << endl;
+			ok = false;
+		}
+	}
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include "cache.h"
+
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+
+using namespace std;
+using namespace EventScore;
+
+
+struct Entry {
+	int value{0};
+};
+
+
+bool contains(LRUCache<Entry> &cache, const string &key, int value) {
+	Entry *entry = cache.find(key);
+	return entry && entry->value == value;
+}
+
+
+}
+
+
+/**
+ * Checks the eviction order, the reset of existing entries and capacity
+ * changes of the LRU cache.
+ */
+int main() {
+	bool ok = true;
+	LRUCache<Entry> cache(3);
+
+	cache.insert("a").value = 1;
+	cache.insert("b").value = 2;
+	cache.insert("c").value = 3;
+
+	// "a" becomes the most recently used, "b" is evicted
+	if ( !contains(cache, "a", 1) ) {
+		cerr << "a is missing" << endl;
+		ok = false;
+	}
+
+	cache.insert("d").value = 4;
+
+	if ( cache.size() != 3 || cache.find("b")
+	  || !contains(cache, "c", 3) || !contains(cache, "d", 4)
+	  || !contains(cache, "a", 1) ) {
+		cerr << "the least recently used entry was not evicted" << endl;
+		ok = false;
+	}
+
+	// Inserting an existing key resets its value and keeps the size
+	if ( cache.insert("c").value != 0 || cache.size() != 3 ) {
+		cerr << "insert did not reset an existing entry" << endl;
+		ok = false;
+	}
+
+	// Order from the most recently used: c, a, d
+	cache.setCapacity(1);
+	if ( cache.size() != 1 || !cache.find("c") || cache.find("a") ) {
+		cerr << "setCapacity did not keep the most recently used entry" << endl;
+		ok = false;
+	}
+
+	// Without capacity an entry lives until the next insert
+	cache.setCapacity(0);
+	if ( cache.size() != 0 ) {
+		cerr << "setCapacity(0) did not clear the cache" << endl;
+		ok = false;
+	}
+
+	cache.insert("e").value = 5;
+	if ( !contains(cache, "e", 5) ) {
+		cerr << "the inserted entry is not valid until the next insert" << endl;
+		ok = false;
+	}
+
+	cache.insert("f");
+	if ( cache.size() != 1 || cache.find("e") ) {
+		cerr << "an entry without capacity survived the next insert" << endl;
+		ok = false;
+	}
+
+	cache.clear();
+	if ( cache.size() != 0 || cache.find("f") ) {
+		cerr << "clear did not remove all entries" << endl;
+		ok = false;
+	}
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
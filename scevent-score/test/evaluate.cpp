@@ -0,0 +1,306 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include <seiscomp/config/config.h>
+#include <seiscomp/datamodel/arrival.h>
+#include <seiscomp/datamodel/eventparameters.h>
+#include <seiscomp/datamodel/focalmechanism.h>
+#include <seiscomp/datamodel/origin.h>
+#include <seiscomp/io/archive/xmlarchive.h>
+#include <seiscomp/plugins/events/scoreprocessor.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+atomic<size_t> allocationCount{0};
+// The number of origins created in synthetic mode
+constexpr int SyntheticOrigins = 20;
+
+
+struct Measurement {
+	size_t evaluations{0};
+	size_t allocations{0};
+	double seconds{0};
+	double checksum{0};
+};
+
+
+/**
+ * @brief Evaluates all objects several times and counts the time and the
+ *        allocations spent in the evaluations.
+ */
+template <typename Object>
+Measurement measure(Client::ScoreProcessor *processor,
+                    const vector<Object*> &objects, int repetitions) {
+	Measurement m;
+	size_t start = allocationCount;
+	auto startTime = chrono::steady_clock::now();
+
+	for ( int r = 0; r < repetitions; ++r ) {
+		for ( Object *object : objects ) {
+			m.checksum += processor->evaluate(object);
+		}
+	}
+
+	m.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	m.allocations = allocationCount - start;
+	m.evaluations = objects.size() * repetitions;
+	return m;
+}
+
+
+void print(const string &name, const Measurement &m) {
+	cout << left << setw(32) << name << right << setw(10) << m.evaluations;
+
+	if ( !m.evaluations ) {
+		cout << endl;
+		return;
+	}
+
+	cout << fixed << setprecision(0)
+	     << setw(14) << m.evaluations / m.seconds
+	     << setprecision(3)
+	     << setw(12) << m.seconds * 1E6 / m.evaluations
+	     << setprecision(1)
+	     << setw(14) << static_cast<double>(m.allocations) / m.evaluations
+	     << endl;
+}
+
+
+/**
+ * @brief Creates origins with a given number of arrivals from stations
+ *        distributed around the epicenter, like those of a dense network.
+ */
+DataModel::EventParametersPtr createOrigins(int arrivals) {
+	DataModel::EventParametersPtr ep = new DataModel::EventParameters;
+
+	mt19937 rng(42);
+	uniform_real_distribution<double> azimuth(0, 360);
+	uniform_real_distribution<double> distance(0.5, 30);
+	normal_distribution<double> residual(0, 0.5);
+
+	for ( int i = 0; i < SyntheticOrigins; ++i ) {
+		DataModel::OriginPtr origin = DataModel::Origin::Create("Origin/synthetic/" + to_string(i));
+		origin->setTime(DataModel::TimeQuantity(Core::Time(1700000000.0 + i * 60)));
+		origin->setLatitude(DataModel::RealQuantity(0));
+		origin->setLongitude(DataModel::RealQuantity(0));
+		origin->setDepth(DataModel::RealQuantity(10));
+
+		// Locators always set the quality, it is part of the fingerprint
+		DataModel::OriginQuality quality;
+		quality.setUsedPhaseCount(arrivals);
+		quality.setStandardError(0.5);
+		quality.setAzimuthalGap(30);
+		origin->setQuality(quality);
+
+		for ( int k = 0; k < arrivals; ++k ) {
+			DataModel::ArrivalPtr arrival = new DataModel::Arrival;
+			arrival->setPickID("Pick/synthetic/" + to_string(i) + "/" + to_string(k));
+			arrival->setPhase(DataModel::Phase("P"));
+			arrival->setWeight(1.0);
+			arrival->setAzimuth(azimuth(rng));
+			arrival->setDistance(distance(rng));
+			arrival->setTimeResidual(residual(rng));
+			origin->add(arrival.get());
+		}
+
+		ep->add(origin.get());
+
+		// A moment tensor inversion with body and surface waves. Every
+		// second tensor lacks the variance reduction like many tensors of
+		// other agencies.
+		DataModel::FocalMechanismPtr fm = DataModel::FocalMechanism::Create("FocalMechanism/synthetic/" + to_string(i));
+		fm->setTriggeringOriginID(origin->publicID());
+		fm->setStationPolarityCount(arrivals / 2);
+		fm->setMisfit(0.1);
+
+		for ( int k = 0; k < 2; ++k ) {
+			DataModel::MomentTensorPtr mt = DataModel::MomentTensor::Create("MomentTensor/synthetic/" + to_string(i) + "/" + to_string(k));
+			mt->setClvd(0.1);
+			if ( k == 0 ) {
+				mt->setVarianceReduction(80);
+			}
+
+			for ( auto waveType : { DataModel::BODY_WAVES, DataModel::SURFACE_WAVES } ) {
+				DataModel::DataUsedPtr dataUsed = new DataModel::DataUsed;
+				dataUsed->setWaveType(waveType);
+				dataUsed->setStationCount(arrivals / 4);
+				dataUsed->setComponentCount(arrivals / 2);
+				mt->add(dataUsed.get());
+			}
+
+			fm->add(mt.get());
+		}
+
+		ep->add(fm.get());
+	}
+
+	return ep;
+}
+
+
+Client::ScoreProcessorPtr createProcessor(const Config::Config &config) {
+	Client::ScoreProcessorPtr processor = Client::ScoreProcessorFactory::Create("template");
+	if ( !processor ) {
+		cerr << "The score processor 'template' is not registered" << endl;
+		return nullptr;
+	}
+
+	if ( !processor->setup(config) ) {
+		cerr << "Failed to set up the score processor" << endl;
+		return nullptr;
+	}
+
+	return processor;
+}
+
+
+}
+
+
+void *operator new(size_t size) {
+	++allocationCount;
+	if ( void *p = malloc(size ? size : 1) ) {
+		return p;
+	}
+
+	throw bad_alloc();
+}
+
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+
+/**
+ * Evaluates all origins and focal mechanisms of an event parameter dump
+ * with the score processor of this plugin and prints the evaluations per
+ * second and the allocations per evaluation. Origins are evaluated with
+ * the cache disabled, which scores each origin from scratch, and with the
+ * cache, as scevent does when it evaluates the origins of an event again.
+ * Focal mechanisms are evaluated likewise, the cache holds the metrics of
+ * their moment tensors. Instead of a dump, --arrivals=n creates origins
+ * with n arrivals each and a focal mechanism with two moment tensors per
+ * origin.
+ *
+ * Usage: bench_tmplevscore_evaluate events.xml|--arrivals=n [scevent.cfg] [repetitions]
+ */
+int main(int argc, char **argv) {
+	if ( argc < 2 ) {
+		cerr << "Usage: " << argv[0] << " events.xml|--arrivals=n [scevent.cfg] [repetitions, default 100]" << endl;
+		return 1;
+	}
+
+	int repetitions = argc > 3 ? atoi(argv[3]) : 100;
+	if ( repetitions <= 0 ) {
+		cerr << "Invalid number of repetitions: " << argv[3] << endl;
+		return 1;
+	}
+
+	Config::Config config;
+	if ( argc > 2 && !config.readConfig(argv[2]) ) {
+		cerr << "Failed to read " << argv[2] << endl;
+		return 1;
+	}
+
+	DataModel::EventParametersPtr ep;
+	string input = argv[1];
+
+	if ( input.compare(0, 11, "--arrivals=") == 0 ) {
+		int arrivals = atoi(input.c_str() + 11);
+		if ( arrivals <= 0 ) {
+			cerr << "Invalid number of arrivals: " << input << endl;
+			return 1;
+		}
+
+		ep = createOrigins(arrivals);
+	}
+	else {
+		IO::XMLArchive ar;
+		if ( !ar.open(input.c_str()) ) {
+			cerr << "Failed to open " << input << endl;
+			return 1;
+		}
+
+		ar >> ep;
+		ar.close();
+
+		if ( !ep ) {
+			cerr << "No event parameters found in " << input << endl;
+			return 1;
+		}
+	}
+
+	vector<DataModel::Origin*> origins;
+	for ( size_t i = 0; i < ep->originCount(); ++i ) {
+		origins.push_back(ep->origin(i));
+	}
+
+	vector<DataModel::FocalMechanism*> focalMechanisms;
+	for ( size_t i = 0; i < ep->focalMechanismCount(); ++i ) {
+		focalMechanisms.push_back(ep->focalMechanism(i));
+	}
+
+	Client::ScoreProcessorPtr cached = createProcessor(config);
+	config.setInt("scoreProcessors.template.cacheSize", 0);
+	Client::ScoreProcessorPtr uncached = createProcessor(config);
+	if ( !cached || !uncached ) {
+		return 1;
+	}
+
+	// Fill the cache, the first pass scores each origin from scratch
+	measure(cached.get(), origins, 1);
+
+	Measurement full = measure(uncached.get(), origins, repetitions);
+	Measurement hits = measure(cached.get(), origins, repetitions);
+	measure(cached.get(), focalMechanisms, 1);
+	Measurement mechanismsFull = measure(uncached.get(), focalMechanisms, repetitions);
+	Measurement mechanisms = measure(cached.get(), focalMechanisms, repetitions);
+
+	cout << left << setw(32) << "" << right << setw(10) << "count"
+	     << setw(14) << "[1/s]" << setw(12) << "[us]" << setw(14) << "allocations" << endl;
+	print("origins, from scratch", full);
+	print("origins, cached", hits);
+	print("focal mechanisms, from scratch", mechanismsFull);
+	print("focal mechanisms, cached", mechanisms);
+
+	// Keeps the evaluations from being optimized away
+	cout << "checksum " << setprecision(6) << defaultfloat
+	     << full.checksum + hits.checksum + mechanismsFull.checksum
+	        + mechanisms.checksum << endl;
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include "expression.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace EventScore;
+
+
+const double Variables[] = { 3, 4 };
+const string Strings[] = { "XY" };
+
+
+Expression create() {
+	return Expression({ "x", "y" }, { "agency" });
+}
+
+
+string repeat(const string &text, int count) {
+	string result;
+	for ( int i = 0; i < count; ++i ) {
+		result += text;
+	}
+	return result;
+}
+
+
+bool checkValues() {
+	struct Case {
+		const char *text;
+		double      value;
+	};
+
+	const Case cases[] = {
+		// Precedence and associativity
+		{ "1+2*3", 7 },
+		{ "(1+2)*3", 9 },
+		{ "x-y-1", -2 },
+		{ "x/y*2", 1.5 },
+		{ "-x*2", -6 },
+		{ "--x", 3 },
+		{ "1+2<4", 1 },
+		{ "x+1>y", 0 },
+		{ "x < y", 1 },
+		// Functions and string attributes
+		{ "min(x,y)+max(x,y)*2", 11 },
+		{ "sqrt(x*x+y*y)", 5 },
+		{ "abs(-x)", 3 },
+		{ "log(1)+x", 3 },
+		{ "10*agency(\"XY\")+agency(\"AB\")", 10 },
+		// Folded constants with variables
+		{ "2*3+x", 9 },
+		{ "x*(2+3)-y/2*0", 15 },
+		{ "1.5E1-x", 12 }
+	};
+
+	bool ok = true;
+	Expression expr = create();
+
+	for ( const auto &c : cases ) {
+		string error;
+		if ( !expr.compile(c.text, &error) ) {
+			cerr << c.text << ": " << error << endl;
+			ok = false;
+			continue;
+		}
+
+		double value = expr.evaluate(Variables, Strings);
+		if ( value != c.value ) {
+			cerr << c.text << " = " << value << ", expected " << c.value << endl;
+			ok = false;
+		}
+	}
+
+	// Only constant subexpressions are checked at compile time
+	if ( !expr.compile("1/(x-3)") || !isinf(expr.evaluate(Variables, Strings)) ) {
+		cerr << "1/(x-3) must compile and evaluate to infinity" << endl;
+		ok = false;
+	}
+
+	// The string attributes in use
+	expr.compile("x + agency(\"XY\")");
+	if ( !expr.usesString(0) || expr.usesString(1) ) {
+		cerr << "usesString() does not report the used attributes" << endl;
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+bool checkErrors() {
+	struct Case {
+		string text;
+		string error;
+	};
+
+	const Case cases[] = {
+		{ "", "expected a number, a name or '(' at position 1" },
+		{ "x+", "expected a number, a name or '(' at position 3" },
+		{ "x y", "unexpected character at position 3" },
+		{ "(x", "expected ')' at position 3" },
+		{ "z", "unknown variable 'z' at position 2" },
+		{ "exp(x)", "unknown function 'exp' at position 5" },
+		{ "min(x)", "expected ',' at position 6" },
+		{ "agency(XY)", "expected a quoted string at position 8" },
+		{ "agency(\"XY)", "unterminated string at position 8" },
+		{ "1E999", "number out of range at position 1" },
+		// Constants which are not finite
+		{ "x+1/0", "constant subexpression is not finite at position 6" },
+		{ "log(-1)", "constant subexpression is not finite at position 8" },
+		{ "sqrt(0-1)*x", "constant subexpression is not finite at position 10" },
+		{ "1E300*1E300", "constant subexpression is not finite at position 12" },
+		// The program stack is limited, constants are folded first
+		{ repeat("1+(", 40) + "x" + repeat(")", 40), "expression too deeply nested" }
+	};
+
+	bool ok = true;
+	Expression expr = create();
+
+	for ( const auto &c : cases ) {
+		string error;
+		if ( expr.compile(c.text, &error) ) {
+			cerr << c.text.substr(0, 40) << ": compiled, expected '" << c.error << "'" << endl;
+			ok = false;
+		}
+		else if ( error != c.error ) {
+			cerr << c.text.substr(0, 40) << ": '" << error << "', expected '"
+			     << c.error << "'" << endl;
+			ok = false;
+		}
+
+		if ( !expr.empty() ) {
+			cerr << c.text.substr(0, 40) << ": a failed compilation left a program" << endl;
+			ok = false;
+		}
+	}
+
+	// The same nesting folds into a single constant
+	string folded = repeat("1+(", 40) + "1" + repeat(")", 40) + "+x";
+	if ( !expr.compile(folded) || expr.evaluate(Variables, Strings) != 44 ) {
+		cerr << "a nested constant was not folded" << endl;
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+/**
+ * Input which would overflow the stack of the recursive parser, the
+ * emitter or the destructor of the syntax tree must be rejected while it
+ * is parsed.
+ */
+bool checkNestingLimit() {
+	const string cases[] = {
+		repeat("(", 100000) + "x" + repeat(")", 100000),
+		repeat("-", 100000) + "x",
+		"x" + repeat("+x", 100000),
+		repeat("min(x,", 100000) + "x" + repeat(")", 100000),
+		repeat("(", 100000)
+	};
+
+	bool ok = true;
+	Expression expr = create();
+
+	for ( const auto &text : cases ) {
+		string error;
+		if ( expr.compile(text, &error) ) {
+			cerr << text.substr(0, 20) << "...: compiled" << endl;
+			ok = false;
+		}
+		else if ( error.find("too deeply nested") == string::npos ) {
+			cerr << text.substr(0, 20) << "...: " << error << endl;
+			ok = false;
+		}
+	}
+
+	// Moderate nesting is fine
+	if ( !expr.compile(repeat("(", 90) + "x" + repeat(")", 90)) ) {
+		cerr << "90 parentheses were rejected" << endl;
+		ok = false;
+	}
+
+	return ok;
+}
+
+
+}
+
+
+int main() {
+	bool ok = true;
+
+	for ( auto check : { checkValues, checkErrors, checkNestingLimit } ) {
+		ok = check() && ok;
+	}
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
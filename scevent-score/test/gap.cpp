@@ -0,0 +1,147 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include <seiscomp/config/config.h>
+#include <seiscomp/datamodel/arrival.h>
+#include <seiscomp/datamodel/origin.h>
+#include <seiscomp/plugins/events/scoreprocessor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+//! The largest gap of the sorted azimuths
+double referenceGap(vector<double> azimuths) {
+	if ( azimuths.size() < 2 ) {
+		return 360;
+	}
+
+	sort(azimuths.begin(), azimuths.end());
+	double gap = azimuths.front() + 360 - azimuths.back();
+	for ( size_t i = 1; i < azimuths.size(); ++i ) {
+		gap = max(gap, azimuths[i] - azimuths[i-1]);
+	}
+	return gap;
+}
+
+
+//! Returns the gap the score processor derives from the arrivals
+double processorGap(Client::ScoreProcessor *processor,
+                    const vector<double> &azimuths, int index) {
+	DataModel::OriginPtr origin = DataModel::Origin::Create("Origin/gap/" + to_string(index));
+	for ( size_t i = 0; i < azimuths.size(); ++i ) {
+		DataModel::ArrivalPtr arrival = new DataModel::Arrival;
+		arrival->setPickID("Pick/" + to_string(i));
+		arrival->setWeight(1.0);
+		arrival->setAzimuth(azimuths[i]);
+		origin->add(arrival.get());
+	}
+
+	// An unused arrival does not close the gap
+	DataModel::ArrivalPtr unused = new DataModel::Arrival;
+	unused->setPickID("Pick/unused");
+	unused->setWeight(0.0);
+	unused->setAzimuth(azimuths.empty() ? 0 : azimuths[0] + 180);
+	origin->add(unused.get());
+
+	return processor->evaluate(origin.get());
+}
+
+
+}
+
+
+/**
+ * Checks the azimuthal gap of the score processor, which puts the
+ * azimuths into buckets, against the gap of the sorted azimuths. The
+ * expression "gap" makes the score the gap.
+ */
+int main() {
+	Config::Config config;
+	config.setString("scoreProcessors.template.expression", "gap");
+	config.setInt("scoreProcessors.template.cacheSize", 0);
+
+	Client::ScoreProcessorPtr processor = Client::ScoreProcessorFactory::Create("template");
+	if ( !processor || !processor->setup(config) ) {
+		cerr << "Failed to create the score processor 'template'" << endl;
+		return 1;
+	}
+
+	struct Case {
+		vector<double> azimuths;
+		double         gap;
+	};
+
+	const Case cases[] = {
+		{ {}, 360 },
+		{ { 10 }, 360 },
+		{ { 0, 90, 180, 270 }, 90 },
+		{ { 350, 10 }, 340 },
+		{ { 10, 20, 30 }, 340 },
+		{ { 5, 5, 5, 5 }, 360 },
+		// Azimuths are normalized to [0,360)
+		{ { -10, 10 }, 340 },
+		{ { 360, 370, 180 }, 180 },
+		{ { 0, 359.5 }, 359.5 }
+	};
+
+	bool ok = true;
+	int index = 0;
+
+	for ( const auto &c : cases ) {
+		double gap = processorGap(processor.get(), c.azimuths, index++);
+		if ( abs(gap - c.gap) > 1E-9 ) {
+			cerr << "case " << index << ": gap " << gap << ", expected " << c.gap << endl;
+			ok = false;
+		}
+	}
+
+	// Random networks from a few clustered stations to dense ones
+	mt19937 rng(42);
+	uniform_real_distribution<double> azimuth(0, 360);
+	normal_distribution<double> cluster(0, 5);
+
+	for ( int n : { 2, 3, 5, 8, 16, 50, 200, 1000 } ) {
+		for ( int r = 0; r < 20; ++r ) {
+			vector<double> azimuths(n);
+			double center = azimuth(rng);
+			for ( auto &value : azimuths ) {
+				value = r % 2 ? azimuth(rng) : fmod(center + cluster(rng) + 360, 360);
+			}
+
+			double gap = processorGap(processor.get(), azimuths, index++);
+			double expected = referenceGap(azimuths);
+			if ( abs(gap - expected) > 1E-9 ) {
+				cerr << n << " azimuths: gap " << gap << ", expected " << expected << endl;
+				ok = false;
+			}
+		}
+	}
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
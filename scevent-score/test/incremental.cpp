@@ -0,0 +1,159 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include <seiscomp/config/config.h>
+#include <seiscomp/datamodel/arrival.h>
+#include <seiscomp/datamodel/origin.h>
+#include <seiscomp/plugins/events/scoreprocessor.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+
+
+namespace {
+
+
+using namespace std;
+using namespace Seiscomp;
+
+
+constexpr int Arrivals = 300;
+// Arrivals appended per update
+constexpr int Step = 23;
+
+
+Client::ScoreProcessorPtr createProcessor(const Config::Config &config) {
+	Client::ScoreProcessorPtr processor = Client::ScoreProcessorFactory::Create("template");
+	if ( !processor || !processor->setup(config) ) {
+		cerr << "Failed to create the score processor 'template'" << endl;
+		return nullptr;
+	}
+
+	return processor;
+}
+
+
+DataModel::ArrivalPtr createArrival(mt19937 &rng, int index) {
+	uniform_real_distribution<double> azimuth(0, 360);
+	normal_distribution<double> residual(0, 0.5);
+
+	DataModel::ArrivalPtr arrival = new DataModel::Arrival;
+	arrival->setPickID("Pick/" + to_string(index));
+	arrival->setPhase(DataModel::Phase("P"));
+	// Every fifth arrival is not used
+	arrival->setWeight(index % 5 ? 1.0 : 0.0);
+	arrival->setAzimuth(azimuth(rng));
+	arrival->setTimeResidual(residual(rng));
+	return arrival;
+}
+
+
+//! Sets the attributes a locator updates with each relocation
+void locate(DataModel::Origin *origin, double latitude, double standardError) {
+	origin->setTime(DataModel::TimeQuantity(Core::Time(1700000000.0)));
+	origin->setLatitude(DataModel::RealQuantity(latitude));
+	origin->setLongitude(DataModel::RealQuantity(10));
+	origin->setDepth(DataModel::RealQuantity(10));
+
+	DataModel::OriginQuality quality;
+	quality.setUsedPhaseCount(static_cast<int>(origin->arrivalCount()));
+	quality.setStandardError(standardError);
+	origin->setQuality(quality);
+}
+
+
+bool compare(const string &step, Client::ScoreProcessor *incremental,
+             Client::ScoreProcessor *full, DataModel::Origin *origin) {
+	double expected = full->evaluate(origin);
+	double score = incremental->evaluate(origin);
+	if ( score != expected ) {
+		cerr << step << ": the cached score " << score << " differs from "
+		     << expected << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+}
+
+
+/**
+ * Compares the scores of the cached processor, which adds appended
+ * arrivals to its aggregates, with the scores of a processor without
+ * cache while an origin is updated like a locator does: arrivals are
+ * appended, existing arrivals change with a relocation and arrivals
+ * are removed.
+ */
+int main() {
+	Config::Config config;
+	Client::ScoreProcessorPtr incremental = createProcessor(config);
+	config.setInt("scoreProcessors.template.cacheSize", 0);
+	Client::ScoreProcessorPtr full = createProcessor(config);
+	if ( !incremental || !full ) {
+		return 1;
+	}
+
+	mt19937 rng(42);
+	DataModel::OriginPtr origin = DataModel::Origin::Create("Origin/incremental");
+	locate(origin.get(), 50, 0.5);
+
+	bool ok = true;
+
+	// Appended arrivals without relocation
+	for ( int i = 0; i < Arrivals; ++i ) {
+		origin->add(createArrival(rng, i).get());
+		if ( (i + 1) % Step == 0 ) {
+			ok = compare("append " + to_string(i + 1), incremental.get(), full.get(), origin.get()) && ok;
+		}
+	}
+
+	ok = compare("append", incremental.get(), full.get(), origin.get()) && ok;
+
+	// The residual, azimuth and weight of existing arrivals change, the
+	// origin is relocated
+	for ( size_t i = 0; i < origin->arrivalCount(); i += 7 ) {
+		DataModel::Arrival *arrival = origin->arrival(i);
+		arrival->setTimeResidual(3.0);
+		arrival->setAzimuth(180.0);
+		arrival->setWeight(arrival->weight() > 0 ? 0.0 : 1.0);
+	}
+
+	locate(origin.get(), 50.1, 0.8);
+	ok = compare("change", incremental.get(), full.get(), origin.get()) && ok;
+
+	// Relocated with additional arrivals
+	for ( int i = Arrivals; i < Arrivals + Step; ++i ) {
+		origin->arrival(i - Arrivals)->setTimeResidual(-1.0);
+		origin->add(createArrival(rng, i).get());
+	}
+
+	locate(origin.get(), 50.2, 0.7);
+	ok = compare("change and append", incremental.get(), full.get(), origin.get()) && ok;
+
+	// Removed arrivals
+	while ( origin->arrivalCount() > Arrivals / 2 ) {
+		origin->removeArrival(origin->arrivalCount() - 1);
+	}
+
+	locate(origin.get(), 50.3, 0.6);
+	ok = compare("remove", incremental.get(), full.get(), origin.get()) && ok;
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+
+#include "weighttable.h"
+
+#include <iostream>
+#include <string>
+
+
+namespace {
+
+
+using namespace std;
+using namespace EventScore;
+
+
+}
+
+
+/**
+ * Checks the lookups of the perfect hash table for small and large
+ * tables, unknown names and the rejection of duplicate names.
+ */
+int main() {
+	bool ok = true;
+	WeightTable table;
+
+	if ( !table.empty() || table.lookup("XY") != 0 ) {
+		cerr << "a new table is not empty" << endl;
+		ok = false;
+	}
+
+	if ( !table.build({ { "XY", 10 }, { "AB", -5 }, { "", 3 } })
+	  || table.lookup("XY") != 10 || table.lookup("AB") != -5
+	  || table.lookup("") != 3 || table.lookup("XZ") != 0
+	  || table.lookup("XYZ") != 0 ) {
+		cerr << "lookups of a small table failed" << endl;
+		ok = false;
+	}
+
+	// Names of similar agency IDs and authors
+	WeightTable::Entries entries;
+	for ( int i = 0; i < 2000; ++i ) {
+		entries.emplace_back("agency" + to_string(i), i + 1);
+		entries.emplace_back("scautoloc@host" + to_string(i), -(i + 1));
+	}
+
+	if ( !table.build(entries) ) {
+		cerr << "building a large table failed" << endl;
+		ok = false;
+	}
+
+	for ( const auto &entry : entries ) {
+		if ( table.lookup(entry.first) != entry.second ) {
+			cerr << entry.first << ": " << table.lookup(entry.first)
+			     << ", expected " << entry.second << endl;
+			ok = false;
+			break;
+		}
+	}
+
+	if ( table.lookup("agency2000") != 0 || table.lookup("XY") != 0 ) {
+		cerr << "an unknown name of a large table has a weight" << endl;
+		ok = false;
+	}
+
+	// A rebuild replaces the content, duplicates clear the table
+	if ( table.build({ { "XY", 1 }, { "XY", 2 } }) || !table.empty()
+	  || table.lookup("XY") != 0 || table.lookup("agency1") != 0 ) {
+		cerr << "duplicate names were accepted" << endl;
+		ok = false;
+	}
+
+	if ( !table.build({}) || !table.empty() ) {
+		cerr << "an empty table was rejected" << endl;
+		ok = false;
+	}
+
+	cout << (ok ? "ok" : "failed") << endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#include "weighttable.h"
+
+#include <set>
+
+
+using namespace std;
+
+
+namespace EventScore {
+
+
+namespace {
+
+
+// Seeds tried per table size before the table grows
+constexpr uint64_t SeedsPerSize = 64;
+
+
+}
+
+
+bool WeightTable::build(const Entries &entries) {
+	_slots.clear();
+	_seed = _mask = 0;
+
+	if ( entries.empty() ) {
+		return true;
+	}
+
+	set<string> names;
+	for ( const auto &entry : entries ) {
+		if ( !names.insert(entry.first).second ) {
+			return false;
+		}
+	}
+
+	// Start with a load factor of at most 0.5 and grow until a seed
+	// without collisions is found.
+	size_t size = 1;
+	while ( size < 2 * entries.size() ) {
+		size <<= 1;
+	}
+
+	vector<bool> used;
+
+	while ( true ) {
+		for ( uint64_t seed = 0; seed < SeedsPerSize; ++seed ) {
+			used.assign(size, false);
+			bool collision = false;
+
+			for ( const auto &entry : entries ) {
+				size_t index = hash(entry.first, seed) & (size - 1);
+				if ( used[index] ) {
+					collision = true;
+					break;
+				}
+				used[index] = true;
+			}
+
+			if ( collision ) {
+				continue;
+			}
+
+			_seed = seed;
+			_mask = size - 1;
+			_slots.resize(size);
+
+			for ( const auto &entry : entries ) {
+				Slot &slot = _slots[hash(entry.first, seed) & _mask];
+				slot.name = entry.first;
+				slot.weight = entry.second;
+				slot.used = true;
+			}
+
+			return true;
+		}
+
+		size <<= 1;
+	}
+}
+
+
+}
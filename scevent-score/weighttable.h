@@ -0,0 +1,98 @@
+/***************************************************************************
+ * Copyright (C) Jan Becker, gempa GmbH                                    *
+ * All rights reserved.                                                    *
+ * Contact: jabe@gempa.de                                                  *
+ *                                                                         *
+ * GNU Affero General Public License Usage                                 *
+ * This file may be used under the terms of the GNU Affero                 *
+ * Public License version 3.0 as published by the Free Software Foundation *
+ * and appearing in the file LICENSE included in the packaging of this     *
+ * file. Please review the following information to ensure the GNU Affero  *
+ * Public License version 3.0 requirements will be met:                    *
+ * https://www.gnu.org/licenses/agpl-3.0.html.                             *
+ ***************************************************************************/
+
+
+#ifndef SEISCOMP_TEMPLATES_EVENTSCORE_WEIGHTTABLE_H
+#define SEISCOMP_TEMPLATES_EVENTSCORE_WEIGHTTABLE_H
+
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace EventScore {
+
+
+/**
+ * @brief A static table of weights by name, e.g. agency IDs.
+ *
+ * The table is built once with a perfect hash: a seed is searched such
+ * that all names hash to different slots. A lookup is then a single hash
+ * and at most one string comparison.
+ *
+ * @code
+ * WeightTable agencies;
+ * agencies.build({{"XY", 10}, {"AB", -5}});
+ * double weight = agencies.lookup(origin->creationInfo().agencyID());
+ * @endcode
+ */
+class WeightTable {
+	// ------------------------------------------------------------------
+	//  Public interface
+	// ------------------------------------------------------------------
+	public:
+		using Entries = std::vector<std::pair<std::string, double>>;
+
+		/**
+		 * @brief Builds the table and replaces the current content.
+		 * @param entries The names and their weights
+		 * @return false if a name is given twice, the table is empty then
+		 */
+		bool build(const Entries &entries);
+
+		bool empty() const { return _slots.empty(); }
+
+		//! Returns the weight of a name or 0 if the name is unknown
+		double lookup(const std::string &name) const {
+			if ( _slots.empty() ) {
+				return 0;
+			}
+
+			const Slot &slot = _slots[hash(name, _seed) & _mask];
+			return slot.used && slot.name == name ? slot.weight : 0;
+		}
+
+
+	// ------------------------------------------------------------------
+	//  Private members
+	// ------------------------------------------------------------------
+	private:
+		struct Slot {
+			std::string name;
+			double      weight{0};
+			bool        used{false};
+		};
+
+		//! FNV-1a with a seeded offset basis
+		static uint64_t hash(const std::string &name, uint64_t seed) {
+			uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+			for ( unsigned char c : name ) {
+				h ^= c;
+				h *= 1099511628211ULL;
+			}
+			return h ^ (h >> 29);
+		}
+
+		std::vector<Slot> _slots;
+		uint64_t          _seed{0};
+		uint64_t          _mask{0};
+};
+
+
+}
+
+
+#endif